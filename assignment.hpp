@@ -8,8 +8,14 @@ the model.
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -19,7 +25,9 @@ the model.
 #include <utility>
 #include <unordered_set>
 #include <vector>
+#include "cancel.hpp"
 #include "definitions.hpp"
+#include "monotone_queue.hpp"
 #include "network.hpp"
 
 using namespace std;
@@ -28,11 +36,38 @@ using namespace concurrency;
 extern string FILE_BASE;
 
 typedef pair<double, int> arc_cost_pair; // priority queue of combined cost/ID pairs sorted by the first element
+typedef pair<int, double> arc_flow_pair; // arc ID/flow pairs for the nonzero flows of a single-destination solution
+typedef pair<vector<arc_flow_pair>, double> strategy_flows; // nonzero flows and waiting time of a single strategy
 
 // Structure declarations
+struct FlatNetwork;
 struct ConstantAssignment;
+struct FrankWolfeState;
 struct NonlinearAssignment;
 
+/**
+Fixed structure of a network, stored in flat arrays indexed by arc and node ID.
+
+Holds the parts of the network that never depend on the fleet vector (the endpoints and types of all arcs and the
+incoming and outgoing arcs of every node), so that the single-destination models can look them up by ID rather than
+following the network's pointers. It is built once by the constant-cost submodel and shared by all of the submodel's
+copies.
+*/
+struct FlatNetwork
+{
+	// Public attributes
+	vector<int> arc_tail; // tail node ID of each arc
+	vector<int> arc_head; // head node ID of each arc
+	vector<bool> boarding; // whether each arc is a boarding arc (the only arcs with finite frequency)
+	vector<int> in_first; // position of each node's first arc in the incoming arc list (plus one past the end)
+	vector<int> in_arcs; // IDs of the incoming arcs of every node, grouped by head node
+	vector<int> out_first; // position of each node's first arc in the outgoing arc list (plus one past the end)
+	vector<int> out_arcs; // IDs of the outgoing arcs of every node, grouped by tail node
+
+	// Public methods
+	FlatNetwork(Network *); // constructor copies the network's fixed structure into flat arrays
+};
+
 /**
 Constant-cost assignment model class.
 
@@ -46,12 +81,65 @@ struct ConstantAssignment
 	// Public attributes
 	Network * Net; // pointer to network object
 	int stop_size; // number of stop nodes in network
+	bool deterministic = false; // whether to sum destination results in a fixed order for reproducible totals
+	int queue_type = QUEUE_RADIX; // priority queue type to use for the label setting algorithm
+	bool warm_start = false; // whether to try replaying each destination's previous label setting run
+	vector<vector<int>> warm_order; // arcs processed by each destination's previous label setting run, in order
+	vector<vector<bool>> warm_chosen; // whether each arc was chosen as attractive when it was previously processed
+	vector<vector<bool>> warm_zero; // whether each arc had zero frequency when it was previously processed
+	bool batch = false; // whether to replay warm starts for several destinations together
+	shared_ptr<const FlatNetwork> Flat; // fixed structure of the network, shared by every copy of this submodel
+	vector<int> active_destinations; // indices of destinations with nonzero incoming demand
+	vector<int> destination_work; // label setting iterations required for each destination in the last evaluation
+	bool sampling = false; // whether to solve only a weighted sample of destinations
+	vector<double> sample_weight; // expansion weight of each destination while sampling (0 if not sampled)
+	vector<double> value_arc_weight; // per-unit-flow value of each arc used to measure each destination's contribution
+	double value_waiting_weight = 0.0; // per-unit-waiting-time value used to measure each destination's contribution
+	vector<double> destination_value; // measured contribution of each destination in the last evaluation
+	bool keep_destinations = false; // whether to keep each destination's results after summing them
+	int max_workers = 0; // maximum number of worker tasks used to solve the destinations (0 for one per processor)
+	CancelToken * Cancel = NULL; // pointer to the cancellation token (NULL if evaluations cannot be cancelled)
+	vector<vector<arc_flow_pair>> destination_flows; // nonzero flows of each destination in the last evaluation
+	vector<double> destination_waiting; // waiting time of each destination in the last evaluation
 
 	// Public methods
 	ConstantAssignment(Network *); // constructor sets network pointer
 	pair<vector<double>, double> calculate(const vector<int> &, const vector<double> &); // calculates flow vector
-	void flows_to_destination(int, vector<double> &, double &, const vector<double> &, const vector<double> &,
-		reader_writer_lock *, reader_writer_lock *); // calculates flow vector and waiting time for a single given sink
+	vector<double> arc_frequencies(const vector<int> &); // returns the frequency of every core arc for a fleet
+	vector<int> schedule(); // returns destinations with nonzero demand in descending order of previous work
+	int flows_to_destination(int, vector<arc_flow_pair> &, double &, const vector<double> &,
+		const vector<double> &); // calculates nonzero flows and waiting time for a single given sink
+	int label_setting(int, vector<double> &, vector<double> &, vector<int> &, const vector<double> &,
+		const vector<double> &); // label setting algorithm for node labels, frequencies, and attractive arcs
+	bool warm_labels(int, vector<double> &, vector<double> &, vector<int> &, const vector<double> &,
+		const vector<double> &); // replays the previous label setting order and checks that it is still valid
+	void flows_to_batch(const vector<int> &, vector<vector<arc_flow_pair>> &, vector<double> &,
+		const vector<double> &, const vector<double> &); // calculates flows for a batch of warm-started sinks
+	void deterministic_sum(const vector<vector<arc_flow_pair>> &, const vector<double> &, vector<double> &,
+		double &); // sums per-destination results in a fixed order
+};
+
+/**
+Progress of the Frank-Wolfe algorithm for a single evaluation.
+
+Keeping everything that changes between iterations in its own object allows several evaluations to be advanced together
+(see NonlinearAssignment::calculate_lockstep()).
+*/
+struct FrankWolfeState
+{
+	// Public attributes
+	vector<double> inv_capacities; // inverse capacity of each core arc for the evaluated fleet
+	pair<vector<double>, double> current; // current flow/waiting pair
+	vector<double> arc_costs; // arc costs at the current solution
+	pair<vector<double>, double> target_previous; // conjugate target of the previous iteration
+	pair<vector<double>, double> target_older; // conjugate target of the iteration before the previous
+	double step_previous = 1.0; // step size of the previous iteration
+	int iteration = 0; // current iteration number
+	double error = INFINITY; // current solution error bound
+	pair<double, double> change = make_pair(INFINITY, INFINITY); // flow/waiting time differences betw consecutive sols
+	int verdict = FEAS_UNKNOWN; // threshold side decided by early termination (if any)
+	bool abandoned = false; // whether the evaluation was abandoned due to cancellation
+	vector<vector<double>> trace_rows; // trace rows recorded so far (only while advanced together with others)
 };
 
 /**
@@ -60,7 +148,16 @@ Nonlinear cost assignment model class.
 Includes a variety of attributes and methods for evaluating the nonlinear cost version of the Spiess and Florian model.
 
 This model is evaluated by conducting the Frank-Wolfe algorithm on a nonlinear program. Each iteration requires solving
-the constant-cost version. The process halts either after an optimality bound cutoff or an iteration cutoff.
+the constant-cost version. The step size is chosen either by an exact line search or by the method of successive
+averages, and the line search can use conjugate or bi-conjugate search directions. The process halts either after an
+optimality bound cutoff or an iteration cutoff.
+
+Simplicial decomposition is available as an alternative solver. It keeps every submodel solution in a pool and optimizes
+over their convex combinations between submodel calls. A destination-based solver is also available, which keeps a pool
+of strategies for each destination and shifts each destination's flow between its own strategies.
+
+Either solver can also halt as soon as the user cost is known to lie on one side of a given threshold (see
+bound_reached()).
 */
 struct NonlinearAssignment
 {
@@ -71,14 +168,68 @@ struct NonlinearAssignment
 	double flow_tol; // flow vector change cutoff for Frank-Wolfe
 	double waiting_tol; // waiting time change cutoff for Frank-Wolfe
 	int max_iterations; // iteration cutoff for Frank-Wolfe
+	int fidelity = FIDELITY_TIGHT; // tolerance profile currently in use
+	bool loose_profile = false; // whether a loose tolerance profile has been specified
+	vector<double> tight_tol; // error, flow, and waiting time cutoffs of the tight profile
+	vector<double> loose_tol; // error, flow, and waiting time cutoffs of the loose profile (negative if unspecified)
+	vector<int> profile_iterations; // iteration cutoffs of the tight and loose profiles, respectively
 	double conical_alpha; // alpha parameter for conical congestion function
 	double conical_beta; // beta parameter for conical congestion function
+	int fw_method = FW_LINE_SEARCH; // method used to choose the Frank-Wolfe step size
+	int engine = ENGINE_FRANK_WOLFE; // equilibrium solver to use
+	vector<double> base_cost; // base cost of each core arc, indexed by arc ID
+	vector<double> uc_arc_weight; // user cost weight of each core arc flow, indexed by arc ID
+	double uc_waiting_weight = 0.0; // user cost weight of the waiting time
+	double uc_threshold = INFINITY; // user cost threshold for early termination (infinite to run to convergence)
+	double gap_margin = 0.0; // multiple of the error bound allowed on each side of the user cost (0 to disable)
+	int verdict = FEAS_UNKNOWN; // threshold side decided by early termination during the most recent evaluation
+	CancelToken * Cancel = NULL; // pointer to the cancellation token (NULL if evaluations cannot be cancelled)
+	bool abandoned = false; // whether the most recent evaluation was abandoned due to cancellation
+	bool trace = false; // whether to write the convergence history of every evaluation to the trace file
+	int trace_evaluation = 0; // number of evaluations written to the trace file
+	vector<vector<double>> trace_rows; // iteration, error, changes, step, and submodel time of each traced iteration
+	vector<int> lockstep_verdicts; // early termination verdict of each evaluation of the most recent lockstep call
+	vector<bool> lockstep_abandoned; // whether each evaluation of the most recent lockstep call was abandoned
 
 	// Public methods
 	NonlinearAssignment(Network *); // constructor reads assignment model data file and sets network pointer
 	~NonlinearAssignment(); // destructor deletes constant-cost submodel
+	NonlinearAssignment * replicate(); // returns a new copy of this object with its own copy of the submodel
 	pair<vector<double>, double> calculate(const vector<int> &, const pair<vector<double>, double> &); // flow vector
+	void set_fidelity(int); // switches between the tight and loose tolerance profiles
+	vector<pair<vector<double>, double>> calculate_lockstep(const vector<vector<int>> &,
+		const pair<vector<double>, double> &); // evaluates several fleets together with a shared task pool
+	vector<pair<vector<double>, double>> lockstep_solve(vector<ConstantAssignment> &, const vector<int> &,
+		const vector<vector<double>> &, const vector<vector<double>> &); // solves several constant-cost models at once
+	pair<vector<double>, double> simplicial_decomposition(const vector<int> &, const vector<double> &,
+		const pair<vector<double>, double> &); // solves the model by simplicial decomposition from an initial solution
+	int restricted_master(const vector<double> &, const vector<pair<vector<double>, double>> &, vector<double> &,
+		pair<vector<double>, double> &, double); // optimizes the convex combination weights of the simplicial pool
+	pair<vector<double>, double> destination_based(const vector<int> &, const vector<double> &,
+		const pair<vector<double>, double> &); // solves the model by shifting flow within each destination
+	void add_strategy(vector<strategy_flows> &, vector<double> &, const vector<arc_flow_pair> &,
+		double); // adds a strategy to a destination's pool
+	int shift_destination(const vector<double> &, pair<vector<double>, double> &, vector<strategy_flows> &,
+		vector<double> &); // shifts a destination's flow from its most to its least expensive strategies
+	vector<arc_flow_pair> combine_flows(const vector<arc_flow_pair> &, double, const vector<arc_flow_pair> &,
+		double); // linear combination of two sorted flow lists
+	void fw_start(FrankWolfeState &, const vector<double> &,
+		const pair<vector<double>, double> &); // initializes Frank-Wolfe progress from an initial solution
+	bool fw_active(FrankWolfeState &); // checks whether Frank-Wolfe should continue according to all stopping rules
+	bool cancelled(); // checks whether the current evaluation should be abandoned, and records it if so
+	void fw_iterate(FrankWolfeState &, const pair<vector<double>, double> &, double); // completes Frank-Wolfe iteration
 	double arc_cost(int, double, double); // calculates the nonlinear cost function for a given arc
+	double arc_cost_derivative(int, double, double); // calculates the derivative of the nonlinear cost function
+	void conjugate_target(const vector<double> &, const pair<vector<double>, double> &, pair<vector<double>, double> &,
+		const pair<vector<double>, double> &, const pair<vector<double>, double> &, double, int); // conjugate target
+	double fused_update(double, const vector<double> &, pair<vector<double>, double> &,
+		const pair<vector<double>, double> &, const pair<vector<double>, double> &, vector<double> &,
+		pair<double, double> &); // calculates error bound, updates solution, and updates costs in a single pass
+	double line_search(const vector<double> &, const vector<double> &, double, const vector<double> &, double); // step
+	double root_search(const function<pair<double, double>(double)> &); // finds where a directional derivative is zero
+	void trace_iteration(int, double, const pair<double, double> &, double, double); // records an iteration's progress
+	void trace_finish(); // writes the most recent evaluation's trace along with the stopping rule that ended it
+	bool bound_reached(const pair<vector<double>, double> &, double); // checks user cost interval against threshold
 	double obj_error(const vector<double> &, const vector<double> &, double, const vector<double> &, double); // err bd
 	pair<double, double> solution_update(double, vector<double> &, double &, const vector<double> &, double); // update
 };
@@ -2,11 +2,75 @@
 
 #include "assignment.hpp"
 
-/// Constant-cost assignment constructor sets network pointer.
+/**
+Flat network constructor copies the fixed structure of a network into flat arrays.
+
+Requires a pointer to the network.
+
+The only arcs with finite frequency are the boarding arcs, and so the frequency of an arc never needs to be compared to
+infinity.
+*/
+FlatNetwork::FlatNetwork(Network * Net)
+{
+	arc_tail.resize(Net->core_arcs.size());
+	arc_head.resize(Net->core_arcs.size());
+	boarding.resize(Net->core_arcs.size());
+	for (int i = 0; i < Net->core_arcs.size(); i++)
+	{
+		arc_tail[i] = Net->core_arcs[i]->tail->id;
+		arc_head[i] = Net->core_arcs[i]->head->id;
+		boarding[i] = Net->core_arcs[i]->boarding;
+	}
+	in_first.push_back(0);
+	out_first.push_back(0);
+	for (int i = 0; i < Net->core_nodes.size(); i++)
+	{
+		for (int j = 0; j < Net->core_nodes[i]->core_in.size(); j++)
+			in_arcs.push_back(Net->core_nodes[i]->core_in[j]->id);
+		for (int j = 0; j < Net->core_nodes[i]->core_out.size(); j++)
+			out_arcs.push_back(Net->core_nodes[i]->core_out[j]->id);
+		in_first.push_back(in_arcs.size());
+		out_first.push_back(out_arcs.size());
+	}
+}
+
+/**
+Constant-cost assignment constructor sets network pointer.
+
+Also finds the destinations with nonzero incoming demand, since these are the only ones whose single-destination models
+contribute anything to the total flows and waiting time.
+
+The parts of the network that never depend on the fleet vector are copied into flat arrays (see FlatNetwork), so that
+the single-destination models can look them up by ID rather than following the network's pointers. Copies of this
+object share the flat arrays, and only copy the per-destination warm start and work information.
+*/
 ConstantAssignment::ConstantAssignment(Network * net_in)
 {
 	Net = net_in;
 	stop_size = Net->stop_nodes.size();
+
+	// Collect all destinations with nonzero incoming demand
+	for (int i = 0; i < stop_size; i++)
+	{
+		for (int j = 0; j < Net->stop_nodes[i]->incoming_demand.size(); j++)
+		{
+			if (Net->stop_nodes[i]->incoming_demand[j] > 0)
+			{
+				active_destinations.push_back(i);
+				break;
+			}
+		}
+	}
+
+	// Store the fixed structure of the network in flat arrays indexed by arc and node ID
+	Flat = make_shared<FlatNetwork>(Net);
+
+	// No work measurements or warm start information exist until the first evaluation
+	destination_work.resize(stop_size, 0);
+	destination_value.resize(stop_size, 0.0);
+	warm_order.resize(stop_size);
+	warm_chosen.resize(stop_size);
+	warm_zero.resize(stop_size);
 }
 
 /**
@@ -19,8 +83,141 @@ Returns a pair containing a vector of flow values and a waiting time scalar.
 This model comes from the linear program formulation of the common line problem, which can be solved using a
 Dijkstra-like label setting algorithm. This must be done separately for every sink node, but each of these problems is
 independent and may be parallelized. The final result is the sum of these individual results.
+
+Destinations with no incoming demand are skipped entirely. The remaining destinations are handed out one at a time to a
+fixed set of worker tasks, in descending order of the work that each one required during the previous evaluation (see
+schedule()), so that the most expensive destinations start first and the cheap ones fill in the gaps at the end.
+
+In batch mode (which requires warm start mode) each worker claims several consecutive destinations at once and solves
+them together (see flows_to_batch()). Since consecutive destinations in the processing order required similar amounts of
+work, they tend to step through their replays in lockstep.
+
+In sampling mode only the destinations with a nonzero sample weight are solved, and each one's flows and waiting time
+are multiplied by its weight, so that the totals estimate the totals over all destinations. If value weights have been
+set then the weighted sum of every solved destination's flows and waiting time is also recorded, which allows its caller
+to estimate the variance of the sampled totals.
+
+In deterministic mode the per-destination results are kept separate until every destination has been solved, and are
+then summed in a fixed order (see deterministic_sum()). Otherwise they are added to the totals under a lock as soon as
+each destination finishes, in which case the rounding of the totals depends on the order in which the threads finish.
+
+If the keep destinations flag is set then the per-destination results are summed as in deterministic mode, and are then
+kept in the destination flow and waiting time attributes for use by the caller.
 */
 pair<vector<double>, double> ConstantAssignment::calculate(const vector<int> &fleet, const vector<double> &arc_costs)
+{
+	vector<double> freq = arc_frequencies(fleet); // frequency of each arc
+
+	vector<double> flows(Net->core_arcs.size(), 0.0); // total flow vector over all destinations
+	double waiting = 0.0; // total waiting time over all destinations
+
+	// Initialize containers for per-destination results (used only in deterministic mode or to keep the results)
+	bool separate = ((deterministic == true) || (keep_destinations == true)); // whether to keep results separate
+	vector<vector<arc_flow_pair>> dest_flows; // nonzero flows for each destination
+	vector<double> dest_waiting; // waiting time for each destination
+	if (separate == true)
+	{
+		dest_flows.resize(stop_size);
+		dest_waiting.resize(stop_size, 0.0);
+	}
+
+	// Initialize reader/writer locks for incrementing the flow and waiting variables for each hyperpath in parallel
+	reader_writer_lock flow_lock; // reader/writer lock for arc flow variables
+	reader_writer_lock wait_lock; // reader/writer lock for total waiting time variable
+
+	// Get destination processing order and the number of worker tasks to process it with
+	vector<int> order = schedule(); // destinations with nonzero demand, longest first
+	int claim = ((warm_start == true) && (batch == true) ? WARM_BATCH : 1); // destinations claimed at once
+	int workers = (max_workers > 0) ? max_workers : (int) GetProcessorCount(); // number of worker tasks
+	workers = min(workers, (int) (order.size() + claim - 1) / claim);
+	atomic<int> next(0); // position of the next unclaimed destination in the processing order
+
+	// Solve single-destination model in parallel for all sinks, each worker claiming the next destinations in order
+	parallel_for(0, workers, [&](int)
+	{
+		for (int k = next.fetch_add(claim); k < order.size(); k = next.fetch_add(claim))
+		{
+			// Stop claiming destinations once the evaluation has been cancelled
+			if ((Cancel != NULL) && (Cancel->cancelled() == true))
+				break;
+
+			// Solve the claimed destinations, either together or individually
+			vector<int> claimed(order.begin() + k, order.begin() + min(k + claim, (int) order.size()));
+			vector<vector<arc_flow_pair>> local_flows(claimed.size()); // nonzero flows for each claimed destination
+			vector<double> local_waiting(claimed.size(), 0.0); // waiting time for each claimed destination
+			if (claimed.size() > 1)
+				flows_to_batch(claimed, local_flows, local_waiting, freq, arc_costs);
+			else
+				destination_work[claimed[0]] = flows_to_destination(claimed[0], local_flows[0], local_waiting[0],
+					freq, arc_costs);
+
+			for (int j = 0; j < claimed.size(); j++)
+			{
+				// Measure each destination's contribution
+				if (value_arc_weight.empty() == false)
+				{
+					destination_value[claimed[j]] = value_waiting_weight * local_waiting[j];
+					for (int i = 0; i < local_flows[j].size(); i++)
+						destination_value[claimed[j]] += value_arc_weight[local_flows[j][i].first] *
+							local_flows[j][i].second;
+				}
+
+				// Expand sampled results to estimate the results of all destinations
+				if (sampling == true)
+				{
+					local_waiting[j] *= sample_weight[claimed[j]];
+					for (int i = 0; i < local_flows[j].size(); i++)
+						local_flows[j][i].second *= sample_weight[claimed[j]];
+				}
+			}
+
+			if (separate == true)
+			{
+				// Keep results in their own slots until all destinations are finished
+				for (int j = 0; j < claimed.size(); j++)
+				{
+					dest_flows[claimed[j]].swap(local_flows[j]);
+					dest_waiting[claimed[j]] = local_waiting[j];
+				}
+				continue;
+			}
+
+			for (int j = 0; j < claimed.size(); j++)
+			{
+				// Process nonzero flows while reader/writer lock is engaged
+				flow_lock.lock();
+				for (int i = 0; i < local_flows[j].size(); i++)
+					flows[local_flows[j][i].first] += local_flows[j][i].second;
+				flow_lock.unlock();
+
+				// Increment total waiting time while reader/writer lock is engaged
+				wait_lock.lock();
+				waiting += local_waiting[j];
+				wait_lock.unlock();
+			}
+		}
+	});
+
+	// In deterministic mode (or when keeping the results), sum all results in a fixed order
+	if (separate == true)
+	{
+		deterministic_sum(dest_flows, dest_waiting, flows, waiting);
+		if (keep_destinations == true)
+		{
+			destination_flows.swap(dest_flows);
+			destination_waiting.swap(dest_waiting);
+		}
+	}
+
+	return make_pair(flows, waiting);
+}
+
+/**
+Returns the frequency of every core arc for a given fleet size vector.
+
+Boarding arcs take the frequency of their line, and all other arcs have infinite frequency.
+*/
+vector<double> ConstantAssignment::arc_frequencies(const vector<int> &fleet)
 {
 	// Generate a vector of line frequencies based on the fleet sizes
 	vector<double> line_freq(Net->lines.size());
@@ -33,98 +230,284 @@ pair<vector<double>, double> ConstantAssignment::calculate(const vector<int> &fl
 		for (int j = 0; j < Net->lines[i]->boarding.size(); j++)
 			freq[Net->lines[i]->boarding[j]->id] = line_freq[i];
 
-	// Initialize reader/writer locks for incrementing the flow and waiting variables for each hyperpath in parallel
-	reader_writer_lock flow_lock; // reader/writer lock for arc flow variables
-	reader_writer_lock wait_lock; // reader/writer lock for total waiting time variable
+	return freq;
+}
 
-	// Solve single-destination model in parallel for all sinks and add all results
-	vector<double> flows(Net->core_arcs.size(), 0.0); // total flow vector over all destinations
-	double waiting = 0.0; // total waiting time over all destinations
-	parallel_for_each(Net->stop_nodes.begin(), Net->stop_nodes.end(), [&](Node * s)
+/**
+Returns the order in which to process the destinations.
+
+Only destinations with nonzero incoming demand (and, in sampling mode, a nonzero sample weight) are included. They are
+sorted in descending order of the number of label setting iterations that they required during the previous evaluation,
+which is a good predictor of their cost in the next evaluation since consecutive evaluations (particularly consecutive
+Frank-Wolfe iterations) differ only slightly in their arc costs. Ties, including the case where no measurements have
+been made yet, keep their original order.
+*/
+vector<int> ConstantAssignment::schedule()
+{
+	vector<int> order;
+	for (int i = 0; i < active_destinations.size(); i++)
+		if ((sampling == false) || (sample_weight[active_destinations[i]] > 0))
+			order.push_back(active_destinations[i]);
+	stable_sort(order.begin(), order.end(), [&](int a, int b)
 	{
-		flows_to_destination(s->id, flows, waiting, freq, arc_costs, &flow_lock, &wait_lock);
+		return destination_work[a] > destination_work[b];
 	});
 
-	return make_pair(flows, waiting);
+	return order;
+}
+
+/**
+Sums the results of all single-destination models in a fixed order.
+
+Requires references to the vector of nonzero flow lists for each destination, the vector of waiting times for each
+destination, the total flow vector, and the total waiting time, respectively. Each flow list must be sorted by arc ID.
+
+The totals are updated in place.
+
+Floating point addition is not associative, so in order for the totals to be bitwise reproducible every arc's flow must
+be accumulated in the same order on every run. Here each arc's total is always summed in ascending order of destination
+index. The work is still done in parallel by dividing the arcs into contiguous blocks, since the order of the additions
+for any single arc does not depend on the block that it falls in or on which thread processes that block.
+*/
+void ConstantAssignment::deterministic_sum(const vector<vector<arc_flow_pair>> &dest_flows,
+	const vector<double> &dest_waiting, vector<double> &flows, double &waiting)
+{
+	int arc_count = flows.size(); // number of arcs to sum over
+	int blocks = (arc_count + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK; // number of arc blocks
+
+	// Sum each block of arcs in parallel, going through the destinations in order
+	parallel_for(0, blocks, [&](int b)
+	{
+		int first = b * REDUCTION_BLOCK; // first arc ID in block
+		int last = min(first + REDUCTION_BLOCK, arc_count); // one past the last arc ID in block
+		for (int s = 0; s < dest_flows.size(); s++)
+		{
+			// Find the first entry of this destination's sorted flow list that falls in the block
+			vector<arc_flow_pair>::const_iterator it = lower_bound(dest_flows[s].begin(), dest_flows[s].end(),
+				arc_flow_pair(first, -INFINITY));
+			for (; (it != dest_flows[s].end()) && (it->first < last); it++)
+				flows[it->first] += it->second;
+		}
+	});
+
+	// Sum waiting times in destination order
+	for (int s = 0; s < dest_waiting.size(); s++)
+		waiting += dest_waiting[s];
 }
 
 /**
 Calculates the flow vector to a given sink.
 
-Requires the sink index (as a position in the stop node list), flow vector, waiting time scalar, line frequency vector,
-arc cost vector, and pointers to the arc flow reader/writer lock and waiting time reader/writer lock, respectively.
+Requires the sink index (as a position in the stop node list), a list to fill with nonzero flows, a waiting time scalar,
+line frequency vector, and arc cost vector, respectively.
+
+The flow list and waiting time are passed by reference and overwritten with the results for this sink. The flow list
+contains an arc ID/flow pair for each arc with nonzero flow, sorted by arc ID. Combining these results over all sinks is
+left to the caller.
 
-The flow vector and waiting time are passed by reference and automatically incremented according to the results of this
-function.
+Returns the number of label setting iterations performed, which is used as a measure of the work required for this sink.
 
 The algorithm here solves the constant-cost, single-destination version of the common lines problem, which is a LP
 similar to min-cost flow and is solvable with a Dijkstra-like label setting algorithm. This process can be parallelized
-over all destinations, and so should rely only on local variables.
+over all destinations, and so should rely only on local variables (other than this sink's own warm start slot).
+
+In warm start mode the order in which the label setting algorithm processed this sink's arcs during the previous
+evaluation is replayed first (see warm_labels()). Only if it is no longer valid for the current costs is the label
+setting algorithm run from scratch.
 */
-void ConstantAssignment::flows_to_destination(int dest, vector<double> &flows, double &waiting,
-	const vector<double> &freq, const vector<double> &arc_costs, reader_writer_lock *flow_lock,
-	reader_writer_lock *wait_lock)
+int ConstantAssignment::flows_to_destination(int dest, vector<arc_flow_pair> &flows, double &waiting,
+	const vector<double> &freq, const vector<double> &arc_costs)
 {
 	/*
-	To explain a few technical details, the label setting algorithm involves updating a distance label for each node. In
-	each iteration, we choose the unprocessed arc with the minimum value of its own cost plus its head's label. In order
-	to speed up that search, we store all of those values in a min-priority queue. As with Dijkstra's algorithm, to get
-	around the inability to update priorities, we just add extra copies to the queue whenever they are updated. We also
-	store a master list of those values, which should always decrease as the algorithm moves forward, as a comparison
-	every time we pop something out of the queue to ensure that we have the latest version.
-
 	The arc loading algorithm involves processing all of the selected attractive arcs in descending order of their
-	cost-plus-head-label from the label setting algorithm. This is accomplished in a similar way, with a copy of the
-	cost-plus-head-label being added to a max-priority queue each time the tail label is updated.
+	cost-plus-head-label from the label setting algorithm. This is accomplished by placing a copy of the final
+	cost-plus-head-label of every attractive arc into a max-priority queue.
 	*/
 
+	// Look up the fixed network structure
+	const vector<int> &arc_tail = Flat->arc_tail; // tail node ID of each arc
+	const vector<int> &arc_head = Flat->arc_head; // head node ID of each arc
+	const vector<bool> &boarding = Flat->boarding; // whether each arc is a boarding arc
+
 	// Initialize variables
-	double chosen_label; // cost-plus-head-label value chosen for current loop iteration
 	int chosen_arc; // arc ID chosen for current loop iteration
 	int chosen_tail; // tail node ID chosen for current loop iteration
 	int chosen_head; // head node ID chosen for current loop iteration
-	int updated_arc; // arc ID for label setting updates
-	double updated_label; // updated label value
 	double added_flow; // chosen arc's added flow volume
+	int work; // number of label setting iterations
 
 	// Initialize containers
 	vector<double> node_label(Net->core_nodes.size(), INFINITY); // tentative distances from every node to destination
-	node_label[Net->stop_nodes[dest]->id] = 0.0; // distance from destination to self is 0
 	vector<double> node_freq(Net->core_nodes.size(), 0.0); // total frequency of all attractive arcs leaving a node
+	vector<int> attractive_arcs; // attractive arcs in the order in which they were chosen
+	priority_queue<arc_cost_pair, vector<arc_cost_pair>, less<arc_cost_pair>> load_queue; // att arcs in reverse order
+
+	// Find node labels and attractive arcs, replaying the previous processing order if it remains valid
+	if ((warm_start == true) && (warm_labels(dest, node_label, node_freq, attractive_arcs, freq, arc_costs) == true))
+		work = warm_order[dest].size();
+	else
+	{
+		if (warm_start == true)
+		{
+			// Discard anything left over from a failed warm start
+			fill(node_label.begin(), node_label.end(), INFINITY);
+			fill(node_freq.begin(), node_freq.end(), 0.0);
+			attractive_arcs.clear();
+		}
+		work = label_setting(dest, node_label, node_freq, attractive_arcs, freq, arc_costs);
+	}
+
+	// Build updated max-priority queue for attractive arc set
+
+	for (int i = 0; i < attractive_arcs.size(); i++)
+	{
+		// Recalculate the cost-plus-head label for each attractive arc and place in a max-priority queue
+		chosen_arc = attractive_arcs[i];
+		load_queue.push(make_pair(node_label[arc_head[chosen_arc]] + arc_costs[chosen_arc], chosen_arc));
+	}
+
+	vector<double>().swap(node_label); // clear node label vector, which is no longer needed
+
+	// Initialize arc loading containers
 	vector<double> node_vol(Net->core_nodes.size(), 0.0); // total flow leaving a node
 	for (int i = 0; i < Net->stop_nodes.size(); i++)
 		// Initialize travel volumes for stop nodes based on demand for destination
 		node_vol[Net->stop_nodes[i]->id] = Net->stop_nodes[dest]->incoming_demand[i];
 	vector<double> node_wait(Net->core_nodes.size(), 0.0); // expected waiting time at each node
-	unordered_set<int> unprocessed_arcs; // arcs not yet chosen in main label setting loop
-	for (int i = 0; i < Net->core_arcs.size(); i++)
-		// All arcs are initially unprocessed
-		unprocessed_arcs.insert(Net->core_arcs[i]->id);
-	priority_queue<arc_cost_pair, vector<arc_cost_pair>, greater<arc_cost_pair>> arc_queue;
-	for (int i = 0; i < Net->stop_nodes[dest]->core_in.size(); i++)
+
+	// Main arc loading loop
+
+	flows.clear();
+	while (load_queue.empty() == false)
+	{
+		// Process attractive arcs in descending order of cost-plus-head-label value
+
+		// Get next arc's properties and remove from queue
+		chosen_arc = load_queue.top().second;
+		load_queue.pop();
+		chosen_tail = arc_tail[chosen_arc];
+		chosen_head = arc_head[chosen_arc];
+
+		// Distribute volume from tail
+		if (boarding[chosen_arc] == true)
+		{
+			// Finite-frequency arc
+			added_flow = (freq[chosen_arc] / node_freq[chosen_tail]) * node_vol[chosen_tail]; // distribute flow
+			node_wait[chosen_tail] = max(node_wait[chosen_tail], added_flow / freq[chosen_arc]); // update waiting time
+		}
+		else
+			// Infinite-frequency arc
+			added_flow = node_vol[chosen_tail]; // all flow goes to single outgoing arc
+
+		// If this results in a nonzero flow increase, update the head and add the change to the output list
+		if (added_flow > 0)
+		{
+			node_vol[chosen_head] += added_flow;
+			flows.push_back(make_pair(chosen_arc, added_flow));
+		}
+	}
+
+	// Sort nonzero flows by arc ID
+	sort(flows.begin(), flows.end());
+
+	// Sum all waiting times
+	waiting = 0.0;
+	for (int i = 0; i < node_wait.size(); i++)
+		waiting += node_wait[i];
+
+	return work;
+}
+
+/**
+Runs the label setting algorithm for a given sink.
+
+Requires the sink index (as a position in the stop node list), references to the node label and node frequency vectors
+(which should be initialized to infinity and zero, respectively), a list to fill with the attractive arcs, and the line
+frequency and arc cost vectors.
+
+The node labels, node frequencies, and attractive arc list are updated in place. The attractive arcs are listed in the
+order in which they were chosen, which is ascending order of their cost-plus-head-label values. In warm start mode the
+order in which all arcs were processed, whether each was chosen, and whether each had zero frequency, is also stored in
+this sink's warm start slot.
+
+Returns the number of label setting iterations performed.
+*/
+int ConstantAssignment::label_setting(int dest, vector<double> &node_label, vector<double> &node_freq,
+	vector<int> &attractive_arcs, const vector<double> &freq, const vector<double> &arc_costs)
+{
+	/*
+	To explain a few technical details, the label setting algorithm involves updating a distance label for each node. In
+	each iteration, we choose the unprocessed arc with the minimum value of its own cost plus its head's label. In order
+	to speed up that search, we store all of those values in a min-priority queue. Since the chosen values never
+	decrease this can be a radix heap rather than a binary heap (see monotone_queue.hpp). As with Dijkstra's algorithm,
+	to get around the inability to update priorities, we just add extra copies to the queue whenever they are updated.
+	We also store a master list of those values, which should always decrease as the algorithm moves forward, as a
+	comparison every time we pop something out of the queue to ensure that we have the latest version.
+
+	Arcs leaving a node can stop being attractive if an infinite-frequency arc is later chosen for the same node, so the
+	order of choice is recorded separately from a flag marking which arcs remain attractive at the end.
+	*/
+
+	// Look up the fixed network structure
+	const vector<int> &arc_tail = Flat->arc_tail; // tail node ID of each arc
+	const vector<bool> &boarding = Flat->boarding; // whether each arc is a boarding arc
+	const vector<int> &in_first = Flat->in_first; // position of each node's first incoming arc
+	const vector<int> &in_arcs = Flat->in_arcs; // incoming arcs of every node
+	const vector<int> &out_first = Flat->out_first; // position of each node's first outgoing arc
+	const vector<int> &out_arcs = Flat->out_arcs; // outgoing arcs of every node
+
+	// Initialize variables
+	double chosen_label; // cost-plus-head-label value chosen for current loop iteration
+	int chosen_arc; // arc ID chosen for current loop iteration
+	int chosen_tail; // tail node ID chosen for current loop iteration
+	int updated_arc; // arc ID for label setting updates
+	double updated_label; // updated label value
+	int work = 0; // number of label setting iterations
+
+	// Initialize containers
+	int sink = Net->stop_nodes[dest]->id; // node ID of the sink
+	node_label[sink] = 0.0; // distance from destination to self is 0
+	vector<bool> processed(Net->core_arcs.size(), false); // whether each arc has been chosen in main label setting loop
+	int unprocessed = Net->core_arcs.size(); // number of arcs not yet chosen
+	MonotoneQueue<int> arc_queue(queue_type); // min-priority queue of cost-plus-head-label/arc ID pairs
+	for (int i = in_first[sink]; i < in_first[sink + 1]; i++)
 		// Set all non-infinite arc labels (which will include only the sink node's incoming arcs)
-		arc_queue.push(make_pair(arc_costs[Net->stop_nodes[dest]->core_in[i]->id],
-			Net->stop_nodes[dest]->core_in[i]->id));
-	unordered_set<int> attractive_arcs; // set of attractive arcs
-	priority_queue<arc_cost_pair, vector<arc_cost_pair>, less<arc_cost_pair>> load_queue; // att arcs in reverse order
-	stack<arc_cost_pair> nonzero_flows; // flow increase/arc ID pairs for quickly processing only the nonzero updates
+		arc_queue.push(make_pair(arc_costs[in_arcs[i]], in_arcs[i]));
+	vector<int> chosen_order; // arcs in the order in which they were made attractive
+	vector<bool> attractive(Net->core_arcs.size(), false); // whether each arc is currently attractive
+	if (warm_start == true)
+	{
+		warm_order[dest].clear();
+		warm_chosen[dest].assign(Net->core_arcs.size(), false);
+		warm_zero[dest].assign(Net->core_arcs.size(), false);
+	}
 
 	// Main label setting loop
 
-	while ((unprocessed_arcs.empty() == false) && (arc_queue.empty() == false))
+	while ((unprocessed > 0) && (arc_queue.empty() == false))
 	{
 		// Find the arc that minimizes the sum of its head's label and its own cost
 		chosen_label = arc_queue.top().first;
 		chosen_arc = arc_queue.top().second;
 		arc_queue.pop();
+		work++;
 
 		// Only proceed for unprocessed arcs
-		if (unprocessed_arcs.count(chosen_arc) == 0)
+		if (processed[chosen_arc] == true)
 			continue;
 
 		// Mark arc as processed and get its tail
-		unprocessed_arcs.erase(chosen_arc);
-		chosen_tail = Net->core_arcs[chosen_arc]->tail->id;
+		processed[chosen_arc] = true;
+		unprocessed--;
+		chosen_tail = arc_tail[chosen_arc];
+
+		// Record processing order for the next warm start (including arcs with zero frequency)
+		if (warm_start == true)
+		{
+			warm_order[dest].push_back(chosen_arc);
+			warm_zero[dest][chosen_arc] = (freq[chosen_arc] == 0);
+			warm_chosen[dest][chosen_arc] = ((freq[chosen_arc] > 0) && (node_label[chosen_tail] >= chosen_label));
+		}
 
 		// Skip arcs with zero frequency (can occur for boarding arcs on lines with no vehicles)
 		if (freq[chosen_arc] == 0)
@@ -134,7 +517,7 @@ void ConstantAssignment::flows_to_destination(int dest, vector<double> &flows, d
 		if (node_label[chosen_tail] >= chosen_label)
 		{
 			// Check whether the attractive arc has infinite frequency
-			if (freq[chosen_arc] < INFINITY)
+			if (boarding[chosen_arc] == true)
 			{
 				// Finite-frequency attractive arc (should include only boarding arcs)
 
@@ -159,83 +542,396 @@ void ConstantAssignment::flows_to_destination(int dest, vector<double> &flows, d
 				node_freq[chosen_tail] = INFINITY;
 
 				// Remove all other attractive arcs leaving the tail
-				for (int i = 0; i < Net->core_nodes[chosen_tail]->core_out.size(); i++)
-					attractive_arcs.erase(Net->core_nodes[chosen_tail]->core_out[i]->id);
+				for (int i = out_first[chosen_tail]; i < out_first[chosen_tail + 1]; i++)
+					attractive[out_arcs[i]] = false;
 			}
 
 			// Add arc to attractive arc set
-			attractive_arcs.insert(chosen_arc);
+			attractive[chosen_arc] = true;
+			chosen_order.push_back(chosen_arc);
 
 			// Update arc labels that are affected by the updated tail node
-			for (int i = 0; i < Net->core_nodes[chosen_tail]->core_in.size(); i++)
+			for (int i = in_first[chosen_tail]; i < in_first[chosen_tail + 1]; i++)
 			{
 				// Find arcs to update, recalculate labels, and push updates into priority queue
-				updated_arc = Net->core_nodes[chosen_tail]->core_in[i]->id;
-				updated_label = arc_costs[Net->core_arcs[updated_arc]->id] + node_label[chosen_tail];
+				updated_arc = in_arcs[i];
+				updated_label = arc_costs[updated_arc] + node_label[chosen_tail];
 				arc_queue.push(make_pair(updated_label, updated_arc));
 			}
 		}
 	}
 
-	// Build updated max-priority queue for attractive arc set
+	// Keep only the arcs that remain attractive, in the order in which they were chosen
+	for (int i = 0; i < chosen_order.size(); i++)
+		if (attractive[chosen_order[i]] == true)
+			attractive_arcs.push_back(chosen_order[i]);
+
+	return work;
+}
+
+/**
+Attempts to reuse the previous label setting run of a given sink under the current costs.
+
+Requires the sink index (as a position in the stop node list), references to the node label and node frequency vectors,
+a list to fill with the attractive arcs, and the line frequency and arc cost vectors.
+
+Returns true if the previous run can be repeated, in which case the node labels, node frequencies, and attractive arcs
+are set exactly as the label setting algorithm would set them when breaking ties in some particular way. Returns false
+if there is no previous run or if it cannot be repeated, in which case the label setting algorithm must be run from
+scratch (and the node labels, frequencies, and attractive arcs must first be reset).
+
+Across Frank-Wolfe iterations the arc costs change only gradually, and so the label setting algorithm usually processes
+a sink's arcs in nearly the same order even though all of the labels change. Rather than repeating the priority queue
+search, we process the arcs in their previous order, recomputing each arc's cost-plus-head-label from the current labels
+and applying the same label updates as the label setting algorithm.
+
+Node labels only ever decrease once they become finite, so a processing order is one that the label setting algorithm
+could have chosen as long as its cost-plus-head-labels are nondecreasing. The same set of arcs is processed as long as
+the same set of nodes is reached, which holds if every processed arc's head is reached and no arc is chosen from a node
+that was not reached before. Arcs whose values have swapped places are handled by sorting the order according to the
+values just computed and replaying it again, up to a fixed number of times. A successfully repaired order replaces the
+previous one for the next warm start.
+
+Arcs with zero frequency are kept in the order and skipped just as in the label setting algorithm. The replay fails if
+any arc's frequency has switched between zero and nonzero (as when a line gains or loses its last vehicle), since the
+previous run would have treated that arc differently.
+*/
+bool ConstantAssignment::warm_labels(int dest, vector<double> &node_label, vector<double> &node_freq,
+	vector<int> &attractive_arcs, const vector<double> &freq, const vector<double> &arc_costs)
+{
+	// Look up the fixed network structure
+	const vector<int> &arc_tail = Flat->arc_tail; // tail node ID of each arc
+	const vector<int> &arc_head = Flat->arc_head; // head node ID of each arc
+	const vector<bool> &boarding = Flat->boarding; // whether each arc is a boarding arc
+	const vector<int> &out_first = Flat->out_first; // position of each node's first outgoing arc
+	const vector<int> &out_arcs = Flat->out_arcs; // outgoing arcs of every node
+
+	// Fail if this sink has never been solved
+	if (warm_order[dest].empty() == true)
+		return false;
 
-	for (auto a = attractive_arcs.begin(); a != attractive_arcs.end(); a++)
+	// Initialize variables
+	double chosen_label; // cost-plus-head-label value of current arc
+	double last_label; // largest cost-plus-head-label value so far
+	int chosen_arc; // arc ID chosen for current loop iteration
+	int chosen_tail; // tail node ID chosen for current loop iteration
+	bool sorted; // whether the current replay processed arcs in nondecreasing order
+	bool reachable; // whether the current replay reached exactly the same nodes as before
+
+	// Initialize containers
+	vector<int> order = warm_order[dest]; // arcs in the order in which they are replayed
+	vector<double> order_label(order.size()); // cost-plus-head-label of each arc in the replay order
+	vector<int> position(order.size()); // positions in the replay order, used for reordering
+	vector<bool> reached(Net->core_nodes.size(), false); // whether each node was reached by the previous run
+	vector<bool> attractive(Net->core_arcs.size()); // whether each arc is currently attractive
+	vector<int> chosen_order; // arcs in the order in which they were made attractive
+	for (int i = 0; i < order.size(); i++)
 	{
-		// Recalculate the cost-plus-head label for each attractive arc and place in a max-priority queue
-		load_queue.push(make_pair(node_label[Net->core_arcs[*a]->head->id] + arc_costs[Net->core_arcs[*a]->id], *a));
+		// Fail if any arc's frequency has switched between zero and nonzero
+		if ((freq[order[i]] == 0) != warm_zero[dest][order[i]])
+			return false;
+		if (warm_chosen[dest][order[i]] == true)
+			reached[arc_tail[order[i]]] = true;
 	}
 
-	vector<double>().swap(node_label); // clear node label vector, which is no longer needed
+	for (int pass = 0; pass < WARM_PASSES; pass++)
+	{
+		// Reset labels and attractive arcs for a new replay
+		fill(node_label.begin(), node_label.end(), INFINITY);
+		fill(node_freq.begin(), node_freq.end(), 0.0);
+		fill(attractive.begin(), attractive.end(), false);
+		chosen_order.clear();
+		node_label[Net->stop_nodes[dest]->id] = 0.0;
+		last_label = 0.0;
+		sorted = true;
+		reachable = true;
+
+		// Replay the current order
+		for (int i = 0; i < order.size(); i++)
+		{
+			chosen_arc = order[i];
+			chosen_tail = arc_tail[chosen_arc];
+			chosen_label = arc_costs[chosen_arc] + node_label[arc_head[chosen_arc]];
+			order_label[i] = chosen_label;
+
+			// Note any violation of the label setting algorithm's order or of the set of reached nodes
+			if (chosen_label < last_label)
+				sorted = false;
+			last_label = max(last_label, chosen_label);
+			if (chosen_label >= INFINITY)
+				reachable = false;
+			if (freq[chosen_arc] == 0)
+				continue;
+
+			// Update the tail exactly as in the label setting algorithm
+			if (node_label[chosen_tail] >= chosen_label)
+			{
+				if (reached[chosen_tail] == false)
+					reachable = false;
+
+				if (boarding[chosen_arc] == true)
+				{
+					// Finite-frequency arc
+					if (node_label[chosen_tail] < INFINITY)
+						node_label[chosen_tail] = (node_freq[chosen_tail] * node_label[chosen_tail] +
+							freq[chosen_arc] * chosen_label) / (node_freq[chosen_tail] + freq[chosen_arc]);
+					else
+						node_label[chosen_tail] = (1 / freq[chosen_arc]) + chosen_label;
+					node_freq[chosen_tail] += freq[chosen_arc];
+				}
+				else
+				{
+					// Infinite-frequency arc
+					node_label[chosen_tail] = chosen_label;
+					node_freq[chosen_tail] = INFINITY;
+					for (int j = out_first[chosen_tail]; j < out_first[chosen_tail + 1]; j++)
+						attractive[out_arcs[j]] = false;
+				}
+				attractive[chosen_arc] = true;
+				chosen_order.push_back(chosen_arc);
+			}
+		}
 
-	// Main arc loading loop
+		if (sorted == true)
+		{
+			// A valid order must also reach the same nodes
+			if (reachable == false)
+				return false;
+
+			// Keep only the arcs that remain attractive, in the order in which they were chosen
+			for (int i = 0; i < chosen_order.size(); i++)
+				if (attractive[chosen_order[i]] == true)
+					attractive_arcs.push_back(chosen_order[i]);
+
+			// Store the repaired order and choices for the next warm start
+			fill(warm_chosen[dest].begin(), warm_chosen[dest].end(), false);
+			for (int i = 0; i < chosen_order.size(); i++)
+				warm_chosen[dest][chosen_order[i]] = true;
+			warm_order[dest] = order;
+			return true;
+		}
 
-	while (load_queue.empty() == false)
+		// Reorder according to the values just computed, keeping the current order among ties
+		for (int i = 0; i < position.size(); i++)
+			position[i] = i;
+		stable_sort(position.begin(), position.end(), [&](int i, int j)
+		{
+			return order_label[i] < order_label[j];
+		});
+		vector<int> reordered(order.size());
+		for (int i = 0; i < position.size(); i++)
+			reordered[i] = order[position[i]];
+		order.swap(reordered);
+	}
+
+	return false;
+}
+
+/**
+Calculates the flow vectors to a batch of sinks by replaying their warm starts together.
+
+Requires a list of sink indices (as positions in the stop node list, at most WARM_BATCH of them), references to lists to
+fill with the nonzero arc ID/flow pairs and the waiting times of each sink, and the line frequency and arc cost vectors.
+
+Each sink occupies one lane of the batch. The node labels, node frequencies, node volumes, and waiting times of all
+lanes are stored side by side (lane l of node i is at position i*WARM_BATCH+l), and every step of the replay and of the
+arc loading advances all lanes by one arc, so that the lanes' values for a node share a small block of memory. The arc
+endpoints are read from flat arrays rather than through the network's pointers.
+
+Only the first replay of warm_labels() is performed. A lane whose replay is out of order or reaches a different set of
+nodes drops out of the batch immediately, as does a lane in which any arc's frequency has switched between zero and
+nonzero since its previous run. Once the batch is finished each dropped sink is solved individually by
+flows_to_destination() (which may still repair the order or fall back to a cold start). Every surviving lane performs
+exactly the same arithmetic in the same order as flows_to_destination(), so the results are identical.
+
+The work measurement of each sink is recorded directly.
+*/
+void ConstantAssignment::flows_to_batch(const vector<int> &dests, vector<vector<arc_flow_pair>> &flows,
+	vector<double> &waiting, const vector<double> &freq, const vector<double> &arc_costs)
+{
+	// Look up the fixed network structure
+	const vector<int> &arc_tail = Flat->arc_tail; // tail node ID of each arc
+	const vector<int> &arc_head = Flat->arc_head; // head node ID of each arc
+	const vector<bool> &boarding = Flat->boarding; // whether each arc is a boarding arc
+	const vector<int> &out_first = Flat->out_first; // position of each node's first outgoing arc
+	const vector<int> &out_arcs = Flat->out_arcs; // outgoing arcs of every node
+
+	// Initialize variables
+	int lanes = dests.size(); // number of lanes in use
+	int steps = 0; // number of lockstep steps needed by the longest lane
+	int chosen_arc; // arc ID chosen for current lane
+	int tail; // position of the chosen arc's tail in the lane-interleaved arrays
+	int head; // position of the chosen arc's head in the lane-interleaved arrays
+	double chosen_label; // cost-plus-head-label value of current arc
+	double added_flow; // chosen arc's added flow volume
+	int node_count = Net->core_nodes.size(); // number of nodes
+
+	// Initialize lane-interleaved containers
+	vector<double> node_label(node_count * WARM_BATCH, INFINITY); // tentative distances from every node to each sink
+	vector<double> node_freq(node_count * WARM_BATCH, 0.0); // total frequency of attractive arcs leaving each node
+	vector<char> reached(node_count * WARM_BATCH, false); // whether each node was reached by each lane's previous run
+	vector<char> attractive(Net->core_arcs.size() * WARM_BATCH, false); // whether each arc is currently attractive
+
+	// Initialize per-lane containers
+	vector<bool> active(lanes, true); // whether each lane's replay is still valid
+	vector<double> last_label(lanes, 0.0); // largest cost-plus-head-label value so far in each lane
+	vector<vector<int>> chosen_order(lanes); // arcs in the order in which they were made attractive in each lane
+
+	for (int l = 0; l < lanes; l++)
 	{
-		// Process attractive arcs in descending order of cost-plus-head-label value
+		// Set up each lane, dropping any sink that has never been solved
+		if (warm_order[dests[l]].empty() == true)
+		{
+			active[l] = false;
+			continue;
+		}
+		node_label[Net->stop_nodes[dests[l]]->id * WARM_BATCH + l] = 0.0;
+		for (int i = 0; i < warm_order[dests[l]].size(); i++)
+		{
+			// Drop the lane if any arc's frequency has switched between zero and nonzero
+			chosen_arc = warm_order[dests[l]][i];
+			if ((freq[chosen_arc] == 0) != warm_zero[dests[l]][chosen_arc])
+				active[l] = false;
+			if (warm_chosen[dests[l]][chosen_arc] == true)
+				reached[arc_tail[chosen_arc] * WARM_BATCH + l] = true;
+		}
+		steps = max(steps, (int) warm_order[dests[l]].size());
+	}
 
-		// Get next arc's properties and remove from queue
-		chosen_arc = load_queue.top().second;
-		load_queue.pop();
-		chosen_tail = Net->core_arcs[chosen_arc]->tail->id;
-		chosen_head = Net->core_arcs[chosen_arc]->head->id;
+	// Replay all lanes in lockstep
 
-		// Distribute volume from tail
-		if (freq[chosen_arc] < INFINITY)
+	for (int i = 0; i < steps; i++)
+	{
+		for (int l = 0; l < lanes; l++)
 		{
-			// Finite-frequency arc
-			added_flow = (freq[chosen_arc] / node_freq[chosen_tail]) * node_vol[chosen_tail]; // distribute flow
-			node_wait[chosen_tail] = max(node_wait[chosen_tail], added_flow / freq[chosen_arc]); // update waiting time
+			if ((active[l] == false) || (i >= warm_order[dests[l]].size()))
+				continue;
+
+			chosen_arc = warm_order[dests[l]][i];
+			tail = arc_tail[chosen_arc] * WARM_BATCH + l;
+			head = arc_head[chosen_arc] * WARM_BATCH + l;
+			chosen_label = arc_costs[chosen_arc] + node_label[head];
+
+			// Drop the lane for any violation of the label setting algorithm's order or of the set of reached nodes
+			if ((chosen_label < last_label[l]) || (chosen_label >= INFINITY))
+			{
+				active[l] = false;
+				continue;
+			}
+			last_label[l] = chosen_label;
+			if (freq[chosen_arc] == 0)
+				continue;
+			if ((node_label[tail] >= chosen_label) == false)
+				continue;
+			if (reached[tail] == false)
+			{
+				active[l] = false;
+				continue;
+			}
+
+			// Update the tail exactly as in the label setting algorithm
+			if (boarding[chosen_arc] == true)
+			{
+				// Finite-frequency arc
+				if (node_label[tail] < INFINITY)
+					node_label[tail] = (node_freq[tail] * node_label[tail] + freq[chosen_arc] * chosen_label) /
+						(node_freq[tail] + freq[chosen_arc]);
+				else
+					node_label[tail] = (1 / freq[chosen_arc]) + chosen_label;
+				node_freq[tail] += freq[chosen_arc];
+			}
+			else
+			{
+				// Infinite-frequency arc
+				node_label[tail] = chosen_label;
+				node_freq[tail] = INFINITY;
+				for (int j = out_first[arc_tail[chosen_arc]]; j < out_first[arc_tail[chosen_arc] + 1]; j++)
+					attractive[out_arcs[j] * WARM_BATCH + l] = false;
+			}
+			attractive[chosen_arc * WARM_BATCH + l] = true;
+			chosen_order[l].push_back(chosen_arc);
 		}
-		else
-			// Infinite-frequency arc
-			added_flow = node_vol[chosen_tail]; // all flow goes to single outgoing arc
+	}
 
-		// If this results in a nonzero flow increase, update the head and add the change to an update stack
-		if (added_flow > 0)
+	// Build the arc loading order of each surviving lane, which is descending order of cost-plus-head-label
+
+	vector<vector<arc_cost_pair>> load_order(lanes); // attractive arcs of each lane in reverse order
+	steps = 0;
+	for (int l = 0; l < lanes; l++)
+	{
+		if (active[l] == false)
+			continue;
+
+		// Store choices for the next warm start and list the remaining attractive arcs
+		fill(warm_chosen[dests[l]].begin(), warm_chosen[dests[l]].end(), false);
+		for (int i = 0; i < chosen_order[l].size(); i++)
 		{
-			node_vol[chosen_head] += added_flow;
-			nonzero_flows.push(make_pair(added_flow, chosen_arc));
+			chosen_arc = chosen_order[l][i];
+			warm_chosen[dests[l]][chosen_arc] = true;
+			if (attractive[chosen_arc * WARM_BATCH + l] == true)
+				load_order[l].push_back(make_pair(node_label[arc_head[chosen_arc] * WARM_BATCH + l] +
+					arc_costs[chosen_arc], chosen_arc));
 		}
+		sort(load_order[l].begin(), load_order[l].end(), greater<arc_cost_pair>());
+		steps = max(steps, (int) load_order[l].size());
+		destination_work[dests[l]] = warm_order[dests[l]].size();
 	}
 
-	// Sum all waiting times
-	double total_wait = 0.0;
-	for (int i = 0; i < node_wait.size(); i++)
-		total_wait += node_wait[i];
+	vector<double>().swap(node_label); // clear node label vector, which is no longer needed
+
+	// Initialize lane-interleaved arc loading containers
+	vector<double> node_vol(node_count * WARM_BATCH, 0.0); // total flow leaving each node
+	vector<double> node_wait(node_count * WARM_BATCH, 0.0); // expected waiting time at each node
+	for (int l = 0; l < lanes; l++)
+		for (int i = 0; i < Net->stop_nodes.size(); i++)
+			node_vol[Net->stop_nodes[i]->id * WARM_BATCH + l] = Net->stop_nodes[dests[l]]->incoming_demand[i];
 
-	// Process nonzero flow queue while reader/writer lock is engaged
-	flow_lock->lock();
-	while (nonzero_flows.empty() == false)
+	// Load all lanes in lockstep
+
+	for (int i = 0; i < steps; i++)
 	{
-		chosen_arc = nonzero_flows.top().second;
-		added_flow = nonzero_flows.top().first;
-		flows[chosen_arc] += added_flow; // apply nonzero flow increase from stack
-		nonzero_flows.pop();
+		for (int l = 0; l < lanes; l++)
+		{
+			if ((active[l] == false) || (i >= load_order[l].size()))
+				continue;
+
+			chosen_arc = load_order[l][i].second;
+			tail = arc_tail[chosen_arc] * WARM_BATCH + l;
+			head = arc_head[chosen_arc] * WARM_BATCH + l;
+
+			// Distribute volume from tail
+			if (boarding[chosen_arc] == true)
+			{
+				// Finite-frequency arc
+				added_flow = (freq[chosen_arc] / node_freq[tail]) * node_vol[tail]; // distribute flow
+				node_wait[tail] = max(node_wait[tail], added_flow / freq[chosen_arc]); // update waiting time
+			}
+			else
+				// Infinite-frequency arc
+				added_flow = node_vol[tail]; // all flow goes to single outgoing arc
+
+			// If this results in a nonzero flow increase, update the head and add the change to the output list
+			if (added_flow > 0)
+			{
+				node_vol[head] += added_flow;
+				flows[l].push_back(make_pair(chosen_arc, added_flow));
+			}
+		}
 	}
-	flow_lock->unlock();
 
-	// Increment total waiting time while reader/writer lock is engaged
-	wait_lock->lock();
-	waiting += total_wait;
-	wait_lock->unlock();
+	for (int l = 0; l < lanes; l++)
+	{
+		if (active[l] == false)
+		{
+			// Solve any dropped lane individually
+			destination_work[dests[l]] = flows_to_destination(dests[l], flows[l], waiting[l], freq, arc_costs);
+			continue;
+		}
+
+		// Sort nonzero flows by arc ID and sum all waiting times
+		sort(flows[l].begin(), flows[l].end());
+		waiting[l] = 0.0;
+		for (int i = 0; i < node_count; i++)
+			waiting[l] += node_wait[i * WARM_BATCH + l];
+	}
 }
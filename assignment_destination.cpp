@@ -0,0 +1,267 @@
+/// Destination-based methods of the nonlinear cost assignment model class.
+
+#include "assignment.hpp"
+
+/**
+Nonlinear cost assignment model evaluation by destination-based flow shifting.
+
+Requires a fleet size vector, the inverse capacity vector, and an initial solution produced by the constant-cost
+submodel, whose per-destination results must have been kept.
+
+Returns a pair containing a vector of flow values and a waiting time scalar.
+
+The feasible set of the nonlinear model is the sum of the feasible sets of the single-destination models, so every
+solution can be decomposed into each destination's own flows and waiting time. The Frank-Wolfe algorithm moves all of
+the destinations toward their new strategies by a single common step size, which is what slows its convergence once most
+of the destinations' strategies have settled. Here each destination instead keeps a pool of the strategies that the
+constant-cost submodel has found for it, and its share of the solution is a convex combination of its pool.
+
+Each outer iteration calls the constant-cost submodel once to add every destination's best strategy at the current costs
+to its pool. Each destination's flow is then shifted from its most expensive strategies to its least expensive ones (see
+shift_destination()), with the shifts made for earlier destinations already reflected in the costs seen by later ones.
+This is repeated DESTINATION_SWEEPS times before the costs are updated for the next submodel call. Since the shifts only
+require arithmetic on the strategies' sparse flow lists, they are much cheaper than the submodel.
+
+The stopping rules are the same as for the Frank-Wolfe algorithm (including early termination), with the error bound
+measured against each submodel solution and the solution change measured across each outer iteration.
+*/
+pair<vector<double>, double> NonlinearAssignment::destination_based(const vector<int> &fleet,
+	const vector<double> &inv_capacities, const pair<vector<double>, double> &initial_sol)
+{
+	// Initialize each destination's pool with its share of the initial solution
+	int dest_count = Submodel->destination_flows.size(); // number of destinations
+	vector<vector<strategy_flows>> pools(dest_count); // strategies in each destination's pool
+	vector<vector<double>> weights(dest_count); // convex combination weight of each pooled strategy
+	for (int s = 0; s < dest_count; s++)
+	{
+		pools[s].push_back(make_pair(vector<arc_flow_pair>(), Submodel->destination_waiting[s]));
+		pools[s][0].first.swap(Submodel->destination_flows[s]);
+		weights[s].push_back(1.0);
+	}
+
+	pair<vector<double>, double> sol_current = initial_sol; // current flow/waiting pair
+	int iteration = 0; // current outer iteration number
+	double error = INFINITY; // current solution error bound
+	pair<double, double> change = make_pair(INFINITY, INFINITY); // flow/waiting time differences betw outer iterations
+	vector<double> arc_costs(Net->core_arcs.size()); // arc costs at the current solution
+	verdict = FEAS_UNKNOWN;
+
+	while ((cancelled() == false) && (iteration < max_iterations) && (error > error_tol) &&
+		((change.first > flow_tol) || (change.second > waiting_tol)))
+	{
+		iteration++;
+		cout << '.';
+
+		// Find every destination's best strategy at the current costs
+		for (int i = 0; i < arc_costs.size(); i++)
+			arc_costs[i] = arc_cost(i, sol_current.first[i], inv_capacities[i]);
+		auto submodel_start = chrono::steady_clock::now(); // submodel timer
+		pair<vector<double>, double> sol_target = Submodel->calculate(fleet, arc_costs);
+		double submodel_time = chrono::duration<double>(chrono::steady_clock::now() - submodel_start).count();
+		if (cancelled() == true)
+			// Abandon the iteration if the solve was cut short by cancellation
+			break;
+
+		// Calculate error bound using the costs that were just found
+		error = sol_current.second - sol_target.second;
+		for (int i = 0; i < arc_costs.size(); i++)
+			error += arc_costs[i] * (sol_current.first[i] - sol_target.first[i]);
+		error = abs(error);
+		if (bound_reached(sol_current, error) == true)
+		{
+			trace_iteration(iteration, error, make_pair(-1.0, -1.0), -1, submodel_time);
+			break;
+		}
+
+		// Add the new strategies to the pools and shift each destination's flow between its strategies
+		for (int s = 0; s < dest_count; s++)
+			add_strategy(pools[s], weights[s], Submodel->destination_flows[s], Submodel->destination_waiting[s]);
+		pair<vector<double>, double> sol_previous = sol_current; // solution before this iteration
+		for (int sweep = 0; sweep < DESTINATION_SWEEPS; sweep++)
+			for (int s = 0; s < dest_count; s++)
+				shift_destination(inv_capacities, sol_current, pools[s], weights[s]);
+
+		// Measure the change across the outer iteration
+		change = make_pair(0.0, abs(sol_current.second - sol_previous.second));
+		for (int i = 0; i < sol_current.first.size(); i++)
+			change.first = max(abs(sol_current.first[i] - sol_previous.first[i]), change.first);
+		trace_iteration(iteration, error, change, -1, submodel_time);
+	}
+
+	// Release the destination flows and stop keeping them
+	Submodel->keep_destinations = false;
+	vector<vector<arc_flow_pair>>().swap(Submodel->destination_flows);
+	vector<double>().swap(Submodel->destination_waiting);
+
+	return sol_current;
+}
+
+/**
+Adds a strategy to a destination's pool.
+
+Requires references to the destination's pool and its weights, followed by the new strategy's sorted flow list and its
+waiting time.
+
+The strategy is added with a weight of zero unless it is already in the pool. Strategies whose weights have dropped to
+zero are removed first, and if the pool is still full then its two lowest-weight strategies are replaced by their
+weighted combination, which leaves the destination's flows unchanged.
+*/
+void NonlinearAssignment::add_strategy(vector<strategy_flows> &pool, vector<double> &weight,
+	const vector<arc_flow_pair> &flows, double waiting)
+{
+	// Skip strategies that are already in the pool
+	for (int j = 0; j < pool.size(); j++)
+		if ((pool[j].second == waiting) && (pool[j].first == flows))
+			return;
+
+	// Remove unused strategies, then merge the lightest strategies until there is room for the new one
+	for (int j = pool.size() - 1; j >= 0; j--)
+	{
+		if ((weight[j] <= 0) && (pool.size() > 1))
+		{
+			pool.erase(pool.begin() + j);
+			weight.erase(weight.begin() + j);
+		}
+	}
+	while (pool.size() >= DESTINATION_POOL)
+	{
+		// Find the two lowest-weight strategies
+		int first = 0; // index of lowest-weight strategy
+		for (int j = 1; j < pool.size(); j++)
+			if (weight[j] < weight[first])
+				first = j;
+		int second = (first == 0) ? 1 : 0; // index of second-lowest-weight strategy
+		for (int j = 0; j < pool.size(); j++)
+			if ((j != first) && (weight[j] < weight[second]))
+				second = j;
+
+		// Replace the second by the weighted combination of both and remove the first
+		double total = weight[first] + weight[second];
+		double share = weight[first] / total; // fraction of the combination contributed by the first strategy
+		pool[second].first = combine_flows(pool[first].first, share, pool[second].first, 1 - share);
+		pool[second].second = share*pool[first].second + (1 - share)*pool[second].second;
+		weight[second] = total;
+		pool.erase(pool.begin() + first);
+		weight.erase(weight.begin() + first);
+	}
+
+	pool.push_back(make_pair(flows, waiting));
+	weight.push_back(0.0);
+}
+
+/**
+Shifts a single destination's flow between the strategies in its pool.
+
+Requires references to the inverse capacity vector, the current total solution, and the destination's pool and its
+weights, respectively.
+
+Returns the number of shifts made, and updates the total solution and the weights in place.
+
+Each shift prices every pooled strategy at the current costs (its flows times their arc costs, plus its waiting time),
+and then moves flow from the most expensive strategy with nonzero weight to the least expensive strategy. This moves the
+destination's flows along the direction
+	d = w_worst (s_best - s_worst)
+whose step size in [0,1] is chosen by an exact line search (see line_search() for its derivation) over only the arcs
+used by either strategy. Up to DESTINATION_STEPS shifts are made, stopping early once the two costs are equal. Since
+each search is small it is carried out serially.
+*/
+int NonlinearAssignment::shift_destination(const vector<double> &inv_capacities, pair<vector<double>, double> &current,
+	vector<strategy_flows> &pool, vector<double> &weight)
+{
+	int shifts = 0; // number of shifts made
+	for (int step = 0; (step < DESTINATION_STEPS) && (pool.size() > 1); step++)
+	{
+		// Find the least expensive strategy and the most expensive strategy that is in use
+		int best = -1; // index of least expensive strategy
+		int worst = -1; // index of most expensive strategy with nonzero weight
+		vector<double> cost(pool.size()); // cost of each strategy
+		for (int j = 0; j < pool.size(); j++)
+		{
+			cost[j] = pool[j].second;
+			for (int k = 0; k < pool[j].first.size(); k++)
+				cost[j] += arc_cost(pool[j].first[k].first, current.first[pool[j].first[k].first],
+					inv_capacities[pool[j].first[k].first]) * pool[j].first[k].second;
+			if ((best < 0) || (cost[j] < cost[best]))
+				best = j;
+			if ((weight[j] > 0) && ((worst < 0) || (cost[j] > cost[worst])))
+				worst = j;
+		}
+		if ((worst < 0) || (cost[worst] <= cost[best]))
+			break;
+
+		// Find the direction and the step size that minimizes the objective along it
+		vector<arc_flow_pair> direction = combine_flows(pool[best].first, weight[worst], pool[worst].first,
+			-weight[worst]); // change in arc flows for a full step
+		double waiting_change = weight[worst] * (pool[best].second - pool[worst].second); // change in waiting time
+		auto derivative = [&](double t)
+		{
+			pair<double, double> total = make_pair(waiting_change, 0.0);
+			for (int k = 0; k < direction.size(); k++)
+			{
+				int id = direction[k].first;
+				double d = direction[k].second;
+				double x = current.first[id] + t*d;
+				total.first += arc_cost(id, x, inv_capacities[id]) * d;
+				total.second += arc_cost_derivative(id, x, inv_capacities[id]) * d * d;
+			}
+			return total;
+		};
+		double t = root_search(derivative);
+		if (t == 0)
+			break;
+
+		// Move the flows and the weights by the chosen step
+		for (int k = 0; k < direction.size(); k++)
+			current.first[direction[k].first] += t*direction[k].second;
+		current.second += t*waiting_change;
+		double moved = t*weight[worst]; // weight moved from the worst strategy to the best
+		weight[best] += moved;
+		weight[worst] = (t >= 1) ? 0.0 : weight[worst] - moved;
+		shifts++;
+	}
+
+	return shifts;
+}
+
+/**
+Calculates a linear combination of two sparse flow lists.
+
+Requires the first flow list and its coefficient, followed by the second flow list and its coefficient. Both flow lists
+must be sorted by arc ID.
+
+Returns the combined flow list, sorted by arc ID, leaving out any arcs whose combined flow is exactly zero.
+*/
+vector<arc_flow_pair> NonlinearAssignment::combine_flows(const vector<arc_flow_pair> &first, double first_coef,
+	const vector<arc_flow_pair> &second, double second_coef)
+{
+	vector<arc_flow_pair> combined;
+	int i = 0, j = 0; // positions in the first and second lists
+	while ((i < first.size()) || (j < second.size()))
+	{
+		double value; // combined flow of the next arc
+		int id; // ID of the next arc
+		if ((j >= second.size()) || ((i < first.size()) && (first[i].first < second[j].first)))
+		{
+			id = first[i].first;
+			value = first_coef*first[i].second;
+			i++;
+		}
+		else if ((i >= first.size()) || (second[j].first < first[i].first))
+		{
+			id = second[j].first;
+			value = second_coef*second[j].second;
+			j++;
+		}
+		else
+		{
+			id = first[i].first;
+			value = first_coef*first[i].second + second_coef*second[j].second;
+			i++;
+			j++;
+		}
+		if (value != 0)
+			combined.push_back(make_pair(id, value));
+	}
+
+	return combined;
+}
@@ -0,0 +1,211 @@
+/// Lockstep evaluation methods of the nonlinear cost assignment model class.
+
+#include "assignment.hpp"
+
+/**
+Nonlinear cost assignment model evaluation for several fleet size vectors at once.
+
+Requires a vector of fleet size vectors and an initial solution shared by all of them.
+
+Returns a vector of flow/waiting pairs, one for each fleet size vector, and sets the lockstep verdicts attribute to the
+early termination verdict of each one.
+
+Each Frank-Wolfe iteration ends with a constant-cost model solve, which is parallelized over the destinations and so
+ends with a barrier while the slowest destinations finish. Here the Frank-Wolfe algorithms of all of the fleets are
+advanced together, and each round solves the constant-cost models of every fleet that is still running using a single
+pool of fleet/destination tasks (see lockstep_solve()). One fleet's slowest destinations then overlap with the work of
+the other fleets. Given the same initial solution, each fleet still follows exactly the same iterations as it would
+alone, and stops according to its own stopping rules, after which it simply drops out of the later rounds. If the
+evaluations are cancelled then every fleet that is still running is abandoned.
+
+Constraint::calculate_batch() passes every fleet the same initial solution, whereas one-at-a-time evaluation warm-starts
+each fleet from the one before it unless a parent snapshot is set (see Constraint::set_parent()), so the results only
+match those of one-at-a-time evaluation exactly when a parent snapshot is available and the submodel is in deterministic
+mode.
+
+Each fleet uses its own copy of the constant-cost submodel, so that their warm starts and work measurements are kept
+apart. The copies share the main submodel's fixed network structure (see FlatNetwork) and begin from its most recent
+warm start information and work measurements. Afterwards the main submodel takes over those of the first fleet, so that
+later evaluations are warm-started and scheduled from an up-to-date solve, and the copies are discarded. The
+per-destination results of each fleet are always summed in a fixed order.
+
+Only the Frank-Wolfe algorithm is advanced in lockstep. For the other engines, or for a single fleet, the fleets are
+evaluated one at a time.
+*/
+vector<pair<vector<double>, double>> NonlinearAssignment::calculate_lockstep(const vector<vector<int>> &fleets,
+	const pair<vector<double>, double> &initial_sol)
+{
+	int count = fleets.size(); // number of fleets
+	vector<pair<vector<double>, double>> results(count); // flow/waiting pair of each fleet
+	lockstep_verdicts.assign(count, FEAS_UNKNOWN);
+	lockstep_abandoned.assign(count, false);
+
+	// Evaluate the fleets one at a time if they cannot be advanced together
+	if ((count < 2) || (engine != ENGINE_FRANK_WOLFE))
+	{
+		for (int c = 0; c < count; c++)
+		{
+			results[c] = calculate(fleets[c], initial_sol);
+			lockstep_verdicts[c] = verdict;
+			lockstep_abandoned[c] = abandoned;
+		}
+		return results;
+	}
+
+	cout << '*';
+
+	// Give each fleet its own submodel copy, frequencies, inverse capacities, and initial costs
+	vector<ConstantAssignment> subs(count, *Submodel); // submodel copy of each fleet, sharing the network structure
+	vector<vector<double>> freqs(count); // arc frequencies of each fleet
+	vector<vector<double>> inv_capacities(count, vector<double>(Net->core_arcs.size(), 0.0)); // inv caps of each fleet
+	vector<vector<double>> costs(count, vector<double>(Net->core_arcs.size())); // current arc costs of each fleet
+	vector<FrankWolfeState> states(count); // Frank-Wolfe progress of each fleet
+	for (int c = 0; c < count; c++)
+	{
+		subs[c].keep_destinations = false;
+		freqs[c] = subs[c].arc_frequencies(fleets[c]);
+		for (int i = 0; i < Net->line_arcs.size(); i++)
+			inv_capacities[c][Net->line_arcs[i]->id] = 1.0 /
+				Net->lines[Net->line_arcs[i]->line]->capacity(fleets[c][Net->line_arcs[i]->line]);
+		for (int i = 0; i < costs[c].size(); i++)
+			costs[c][i] = arc_cost(i, initial_sol.first[i], inv_capacities[c][i]);
+	}
+
+	// Solve every fleet's initial constant-cost model together
+	cout << '.';
+	vector<int> active(count); // fleets still running
+	for (int c = 0; c < count; c++)
+		active[c] = c;
+	auto submodel_start = chrono::steady_clock::now(); // submodel timer
+	vector<pair<vector<double>, double>> solved = lockstep_solve(subs, active, freqs, costs); // subproblem solutions
+	double submodel_time = chrono::duration<double>(chrono::steady_clock::now() - submodel_start).count();
+	bool cut_short = ((Cancel != NULL) && (Cancel->cancelled() == true)); // whether the solves were cancelled
+	for (int c = 0; c < count; c++)
+	{
+		trace_rows.swap(states[c].trace_rows);
+		trace_iteration(0, -1, make_pair(-1.0, -1.0), -1, submodel_time);
+		trace_rows.swap(states[c].trace_rows);
+		fw_start(states[c], inv_capacities[c], solved[c]);
+		states[c].abandoned = cut_short;
+	}
+	if (cut_short == true)
+		// Abandon every fleet rather than use initial solves that were cut short by cancellation
+		active.clear();
+
+	// Main Frank-Wolfe loop, with each round advancing every fleet that is still running
+	while (true)
+	{
+		// Drop the fleets that have stopped
+		vector<int> running; // fleets that have not yet stopped
+		for (int k = 0; k < active.size(); k++)
+			if (fw_active(states[active[k]]) == true)
+				running.push_back(active[k]);
+		active.swap(running);
+		if (active.empty() == true)
+			break;
+		cout << '.';
+
+		// Solve the constant-cost models of all running fleets together and complete their iterations
+		for (int k = 0; k < active.size(); k++)
+			costs[active[k]] = states[active[k]].arc_costs;
+		submodel_start = chrono::steady_clock::now();
+		solved = lockstep_solve(subs, active, freqs, costs);
+		submodel_time = chrono::duration<double>(chrono::steady_clock::now() - submodel_start).count();
+		if ((Cancel != NULL) && (Cancel->cancelled() == true))
+		{
+			// Abandon every running fleet rather than use solves that were cut short by cancellation
+			for (int k = 0; k < active.size(); k++)
+				states[active[k]].abandoned = true;
+			break;
+		}
+		for (int k = 0; k < active.size(); k++)
+		{
+			trace_rows.swap(states[active[k]].trace_rows);
+			fw_iterate(states[active[k]], solved[k], submodel_time);
+			trace_rows.swap(states[active[k]].trace_rows);
+		}
+	}
+
+	// Collect each fleet's results and write its trace
+	for (int c = 0; c < count; c++)
+	{
+		results[c].first.swap(states[c].current.first);
+		results[c].second = states[c].current.second;
+		lockstep_verdicts[c] = states[c].verdict;
+		lockstep_abandoned[c] = states[c].abandoned;
+		verdict = states[c].verdict;
+		abandoned = states[c].abandoned;
+		trace_rows.swap(states[c].trace_rows);
+		trace_finish();
+	}
+
+	// Keep the first fleet's warm start information and work measurements for later evaluations
+	Submodel->warm_order.swap(subs[0].warm_order);
+	Submodel->warm_chosen.swap(subs[0].warm_chosen);
+	Submodel->warm_zero.swap(subs[0].warm_zero);
+	Submodel->destination_work.swap(subs[0].destination_work);
+
+	return results;
+}
+
+/**
+Solves the constant-cost models of several fleets using a single pool of fleet/destination tasks.
+
+Requires the vector of submodel copies, the indices of the fleets to solve, and vectors of every fleet's arc frequencies
+and arc costs, respectively.
+
+Returns a vector of flow/waiting pairs, one for each listed fleet, in the same order as the list.
+
+Every destination of every listed fleet becomes a task, and the tasks are handed out to a fixed set of worker tasks in
+descending order of the work that each one required during its fleet's previous solve, as in
+ConstantAssignment::calculate(). The workers only move on to the next round once every task is finished, but by then the
+cheap tasks of all fleets have filled in the gaps left by the expensive ones. Each task writes only to its own fleet's
+submodel copy and its own destination's slots, so no locks are needed.
+*/
+vector<pair<vector<double>, double>> NonlinearAssignment::lockstep_solve(vector<ConstantAssignment> &subs,
+	const vector<int> &active, const vector<vector<double>> &freqs, const vector<vector<double>> &costs)
+{
+	// List every fleet/destination task, longest first
+	vector<pair<int, int>> tasks; // position in the fleet list and destination of each task
+	for (int k = 0; k < active.size(); k++)
+	{
+		vector<int> order = subs[active[k]].schedule(); // this fleet's destinations
+		for (int i = 0; i < order.size(); i++)
+			tasks.push_back(make_pair(k, order[i]));
+	}
+	stable_sort(tasks.begin(), tasks.end(), [&](const pair<int, int> &a, const pair<int, int> &b)
+	{
+		return subs[active[a.first]].destination_work[a.second] > subs[active[b.first]].destination_work[b.second];
+	});
+
+	// Solve all tasks in parallel, with each worker claiming the next task in order
+	vector<vector<vector<arc_flow_pair>>> dest_flows(active.size(), vector<vector<arc_flow_pair>>(Submodel->stop_size));
+	vector<vector<double>> dest_waiting(active.size(), vector<double>(Submodel->stop_size, 0.0));
+	int workers = min((int) GetProcessorCount(), (int) tasks.size()); // number of worker tasks
+	atomic<int> next(0); // position of the next unclaimed task
+	parallel_for(0, workers, [&](int)
+	{
+		for (int t = next.fetch_add(1); t < tasks.size(); t = next.fetch_add(1))
+		{
+			// Stop claiming tasks once the evaluations have been cancelled
+			if ((Cancel != NULL) && (Cancel->cancelled() == true))
+				break;
+
+			int k = tasks[t].first;
+			int dest = tasks[t].second;
+			ConstantAssignment &sub = subs[active[k]];
+			sub.destination_work[dest] = sub.flows_to_destination(dest, dest_flows[k][dest], dest_waiting[k][dest],
+				freqs[active[k]], costs[active[k]]);
+		}
+	});
+
+	// Sum each fleet's results in a fixed order
+	vector<pair<vector<double>, double>> solved(active.size());
+	for (int k = 0; k < active.size(); k++)
+	{
+		solved[k] = make_pair(vector<double>(Net->core_arcs.size(), 0.0), 0.0);
+		subs[active[k]].deterministic_sum(dest_flows[k], dest_waiting[k], solved[k].first, solved[k].second);
+	}
+
+	return solved;
+}
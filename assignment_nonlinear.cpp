@@ -10,6 +10,15 @@ NonlinearAssignment::NonlinearAssignment(Network * net_in)
 	// Initialize submodel object
 	Submodel = new ConstantAssignment(net_in);
 
+	// Copy the arc base costs into a contiguous array
+	base_cost.resize(Net->core_arcs.size());
+	for (int i = 0; i < Net->core_arcs.size(); i++)
+		base_cost[Net->core_arcs[i]->id] = Net->core_arcs[i]->cost;
+
+	// Leave the loose profile unspecified until it is read
+	loose_tol.assign(3, -1.0);
+	profile_iterations.assign(2, -1);
+
 	// Read assignment model data
 	ifstream a_file;
 	a_file.open(FILE_BASE + ASSIGNMENT_FILE);
@@ -48,9 +57,42 @@ NonlinearAssignment::NonlinearAssignment(Network * net_in)
 				conical_alpha = stod(value);
 			if (count == 7)
 				conical_beta = stod(value);
+			if (count == 8)
+				Submodel->deterministic = (stoi(value) == 1);
+			if (count == 9)
+				Submodel->queue_type = stoi(value);
+			if (count == 10)
+				Submodel->warm_start = (stoi(value) == 1);
+			if (count == 11)
+				Submodel->batch = (stoi(value) == 1);
+			if (count == 12)
+				fw_method = stoi(value);
+			if (count == 13)
+				engine = stoi(value);
+			if ((count >= 14) && (count <= 16))
+				loose_tol[count - 14] = stod(value);
+			if (count == 17)
+				profile_iterations[FIDELITY_LOOSE] = stoi(value);
+			if (count == 18)
+				trace = (stoi(value) == 1);
 		}
 
 		a_file.close();
+
+		// Store the tight profile and fill in any unspecified parts of the loose profile
+		tight_tol = { error_tol, flow_tol, waiting_tol };
+		profile_iterations[FIDELITY_TIGHT] = max_iterations;
+		for (int i = 0; i < loose_tol.size(); i++)
+		{
+			if (loose_tol[i] >= 0)
+				loose_profile = true;
+			else
+				loose_tol[i] = tight_tol[i];
+		}
+		if (profile_iterations[FIDELITY_LOOSE] >= 0)
+			loose_profile = true;
+		else
+			profile_iterations[FIDELITY_LOOSE] = max_iterations;
 	}
 	else
 	{
@@ -65,6 +107,43 @@ NonlinearAssignment::~NonlinearAssignment()
 	delete Submodel;
 }
 
+/**
+Creates a copy of this object for use in a separate evaluation context.
+
+Returns a pointer to the new object, which the caller must delete.
+
+The copy shares the network but has its own copy of the constant-cost submodel, including its most recent warm start
+information, so the two objects can be used at the same time. The submodel copy shares the fixed network structure of
+the original (see FlatNetwork).
+*/
+NonlinearAssignment * NonlinearAssignment::replicate()
+{
+	NonlinearAssignment * copy = new NonlinearAssignment(*this);
+	copy->Submodel = new ConstantAssignment(*Submodel);
+	return copy;
+}
+
+/**
+Switches between the tight and loose tolerance profiles.
+
+Requires a profile code (FIDELITY_TIGHT or FIDELITY_LOOSE).
+
+The cutoffs of the chosen profile are copied into the cutoffs used by every solver. The tight profile is made up of the
+main cutoffs from the assignment data file and is used by default, while the loose profile is meant for evaluations
+whose results only need to be approximate. If no loose profile was specified then the tight profile is always used.
+*/
+void NonlinearAssignment::set_fidelity(int level)
+{
+	if (loose_profile == false)
+		level = FIDELITY_TIGHT;
+	fidelity = level;
+	const vector<double> &tol = (level == FIDELITY_LOOSE) ? loose_tol : tight_tol; // chosen profile's cutoffs
+	error_tol = tol[0];
+	flow_tol = tol[1];
+	waiting_tol = tol[2];
+	max_iterations = profile_iterations[level];
+}
+
 /**
 Nonlinear cost assignment model evaluation for a given solution.
 
@@ -86,17 +165,15 @@ pair<vector<double>, double> NonlinearAssignment::calculate(const vector<int> &f
 	cout << '*';
 
 	// Initialize variables
-	pair<vector<double>, double> sol_next; // flow/waiting pair calculated as the linearized submodel solution
-	pair<vector<double>, double> sol_previous; // flow/waiting pair for the previous solution
-	int iteration = 0; // current iteration number
-	double error = INFINITY; // current solution error bound
-	pair<double, double> change = make_pair(INFINITY, INFINITY); // flow/waiting time differences betw consecutive sols
-
-	// Calculate line arc capacities
-	vector<double> capacities(Net->core_arcs.size(), INFINITY);
+	verdict = FEAS_UNKNOWN;
+	abandoned = false;
+	trace_rows.clear();
+
+	// Calculate inverse line arc capacities (0 for uncapacitated arcs and infinite for zero-capacity arcs)
+	vector<double> inv_capacities(Net->core_arcs.size(), 0.0);
 	for_each(Net->line_arcs.begin(), Net->line_arcs.end(), [&](Arc * a)
 	{
-		capacities[a->id] = Net->lines[a->line]->capacity(fleet[a->line]);
+		inv_capacities[a->id] = 1.0 / Net->lines[a->line]->capacity(fleet[a->line]);
 	});
 
 	// Calculate arc costs based on initial flow
@@ -104,57 +181,180 @@ pair<vector<double>, double> NonlinearAssignment::calculate(const vector<int> &f
 	vector<double> arc_costs(Net->core_arcs.size());
 	for_each(Net->core_arcs.begin(), Net->core_arcs.end(), [&](Arc * a)
 	{
-		arc_costs[a->id] = arc_cost(a->id, initial_sol.first[a->id], capacities[a->id]);
+		arc_costs[a->id] = arc_cost(a->id, initial_sol.first[a->id], inv_capacities[a->id]);
 	});
 
-	// Solve constant-cost model once to obtain an initial solution
-	sol_previous = Submodel->calculate(fleet, arc_costs);
+	// Solve constant-cost model once to obtain an initial solution (keeping its destination flows if they are needed)
+	Submodel->keep_destinations = (engine == ENGINE_DESTINATION);
+	auto submodel_start = chrono::steady_clock::now(); // submodel timer
+	pair<vector<double>, double> sol_initial = Submodel->calculate(fleet, arc_costs); // initial submodel solution
+	trace_iteration(0, -1, make_pair(-1.0, -1.0), -1,
+		chrono::duration<double>(chrono::steady_clock::now() - submodel_start).count());
 
-	// Main Frank-Wolfe loop
+	// Abandon the evaluation if the initial solve was cut short by cancellation
+	if (cancelled() == true)
+	{
+		Submodel->keep_destinations = false;
+		vector<vector<arc_flow_pair>>().swap(Submodel->destination_flows);
+		vector<double>().swap(Submodel->destination_waiting);
+		trace_finish();
+		return sol_initial;
+	}
+
+	// Hand the rest of the process to another engine (if selected)
+	if (engine != ENGINE_FRANK_WOLFE)
+	{
+		if (engine == ENGINE_SIMPLICIAL)
+			sol_initial = simplicial_decomposition(fleet, inv_capacities, sol_initial);
+		else
+			sol_initial = destination_based(fleet, inv_capacities, sol_initial);
+		trace_finish();
+		return sol_initial;
+	}
 
-	while ((iteration < max_iterations) && (error > error_tol) &&
-		((change.first > flow_tol) || (change.second > waiting_tol)))
+	// Main Frank-Wolfe loop
+	FrankWolfeState state; // progress of the Frank-Wolfe algorithm
+	fw_start(state, inv_capacities, sol_initial);
+	while (fw_active(state) == true)
 	{
 		// Loop continues until achieving sufficiently low error or reaching an iteration cutoff
-		iteration++;
 		cout << '.';
 
-		// Update all arc costs based on the current flow
-		for_each(Net->core_arcs.begin(), Net->core_arcs.end(), [&](Arc * a)
+		// Solve constant-cost model for the current cost vector
+		submodel_start = chrono::steady_clock::now();
+		pair<vector<double>, double> sol_next = Submodel->calculate(fleet, state.arc_costs); // subproblem solution
+		if ((Cancel != NULL) && (Cancel->cancelled() == true))
 		{
-			arc_costs[a->id] = arc_cost(a->id, sol_previous.first[a->id], capacities[a->id]);
-		});
+			// Abandon the evaluation rather than use a solve that was cut short by cancellation
+			state.abandoned = true;
+			break;
+		}
+		fw_iterate(state, sol_next, chrono::duration<double>(chrono::steady_clock::now() - submodel_start).count());
+	}
 
-		// Solve constant-cost model for given cost vector
-		sol_next = Submodel->calculate(fleet, arc_costs);
+	verdict = state.verdict;
+	abandoned = state.abandoned;
+	trace_finish();
+	return state.current;
+}
 
-		// Calculate new error bound
-		error = obj_error(capacities, sol_previous.first, sol_previous.second, sol_next.first, sol_next.second);
+/**
+Initializes the progress of the Frank-Wolfe algorithm for a single evaluation.
 
-		// Update solution as successive average of consecutive solutions and get maximum elementwise difference
-		change = solution_update(1 - (1.0 / iteration), sol_previous.first, sol_previous.second, sol_next.first,
-			sol_next.second);
+Requires a reference to the state to initialize, followed by the inverse capacity vector and the initial solution.
+*/
+void NonlinearAssignment::fw_start(FrankWolfeState &state, const vector<double> &inv_capacities,
+	const pair<vector<double>, double> &initial_sol)
+{
+	state.inv_capacities = inv_capacities;
+	state.current = initial_sol;
+	state.arc_costs.resize(inv_capacities.size());
+	for (int i = 0; i < state.arc_costs.size(); i++)
+		state.arc_costs[i] = arc_cost(i, state.current.first[i], inv_capacities[i]);
+}
+
+/**
+Returns whether the Frank-Wolfe algorithm should continue for a given state, according to all stopping rules.
+
+Cancellation is checked first. A cancelled evaluation is marked as abandoned even if another stopping rule has also been
+met, since its latest iteration may have been based on an incomplete subproblem solution.
+*/
+bool NonlinearAssignment::fw_active(FrankWolfeState &state)
+{
+	if ((Cancel != NULL) && (Cancel->cancelled() == true))
+	{
+		state.abandoned = true;
+		return false;
 	}
+	if ((state.verdict != FEAS_UNKNOWN) || (state.iteration >= max_iterations) || (state.error <= error_tol) ||
+		((state.change.first <= flow_tol) && (state.change.second <= waiting_tol)))
+		return false;
+	return true;
+}
 
-	return sol_previous;
+/**
+Returns whether the current evaluation should be abandoned, in which case the abandoned attribute is also set.
+
+An evaluation is abandoned if a stop has been requested or its deadline has passed. Its results are then meaningless.
+*/
+bool NonlinearAssignment::cancelled()
+{
+	if ((Cancel != NULL) && (Cancel->cancelled() == true))
+		abandoned = true;
+	return abandoned;
+}
+
+/**
+Carries out the rest of a Frank-Wolfe iteration once its constant-cost subproblem has been solved.
+
+Requires a reference to the state, the subproblem solution at the state's arc costs, and the wall time of the subproblem
+solve (for the trace).
+
+Chooses the step size, takes the step, and updates the error bound, the solution change, and the arc costs. If early
+termination decides the solution's side of the user cost threshold then the state's verdict is set.
+*/
+void NonlinearAssignment::fw_iterate(FrankWolfeState &state, const pair<vector<double>, double> &sol_next,
+	double submodel_time)
+{
+	state.iteration++;
+
+	// Choose step size toward the subproblem solution (or toward a conjugate target for the conjugate methods)
+	double step = 1.0 / state.iteration; // method of successive averages step
+	pair<vector<double>, double> target; // point that the step moves toward (if not the subproblem solution)
+	if (fw_method != FW_MSA)
+	{
+		target = sol_next;
+		if ((fw_method == FW_CONJUGATE) || (fw_method == FW_BICONJUGATE))
+			conjugate_target(state.inv_capacities, state.current, target, state.target_previous, state.target_older,
+				state.step_previous, state.iteration);
+		step = line_search(state.inv_capacities, state.current.first, state.current.second, target.first,
+			target.second);
+
+		// Fall back on the ordinary direction if the conjugate direction does not descend
+		if ((step == 0) && (state.iteration > 1) && (fw_method != FW_LINE_SEARCH))
+		{
+			target = sol_next;
+			step = line_search(state.inv_capacities, state.current.first, state.current.second, target.first,
+				target.second);
+		}
+
+		// Remember the last two targets and the step size for the conjugate methods
+		if (fw_method != FW_LINE_SEARCH)
+		{
+			state.target_older.first.swap(state.target_previous.first);
+			state.target_older.second = state.target_previous.second;
+			state.target_previous = target;
+			state.step_previous = step;
+		}
+	}
+
+	// Calculate the error bound, take the step, and update the arc costs for the next iteration in a single pass
+	state.error = fused_update(step, state.inv_capacities, state.current, sol_next,
+		(fw_method == FW_MSA) ? sol_next : target, state.arc_costs, state.change);
+	trace_iteration(state.iteration, state.error, state.change, step, submodel_time);
+
+	// Stop early if the user cost is already known to lie on one side of the threshold
+	verdict = FEAS_UNKNOWN;
+	if (bound_reached(state.current, state.error) == true)
+		state.verdict = verdict;
 }
 
 /**
 Calculates the nonlinear cost function for a given arc.
 
-Requires the arc ID, arc flow, and arc capacity.
+Requires the arc ID, arc flow, and inverse arc capacity (0 for infinite capacity and infinite for zero capacity).
 
 Returns the arc's cost according to the conical congestion function.
 */
-double NonlinearAssignment::arc_cost(int id, double flow, double capacity)
+double NonlinearAssignment::arc_cost(int id, double flow, double inv_capacity)
 {
 	// Return infinite cost for zero-capacity arcs
-	if (capacity == 0)
+	if (inv_capacity >= INFINITY)
 		return LARGE;
 
 	// Return only the arc's base cost for infinite-capacity or zero-flow arcs
-	if ((capacity >= INFINITY) || (flow == 0))
-		return Net->core_arcs[id]->cost;
+	if ((inv_capacity == 0) || (flow == 0))
+		return base_cost[id];
 
 	/*
 	Otherwise, evaluate the conical congestion function, which is defined as:
@@ -162,16 +362,421 @@ double NonlinearAssignment::arc_cost(int id, double flow, double capacity)
 	where c(x) is the nonlinear cost, x is the arc's flow, c is the arc's base cost, u is the arc's capacity, and alpha
 	and beta are parameters.
 	*/
-	double ratio = 1 - (flow / capacity);
-	return Net->core_arcs[id]->cost * (2 + sqrt(pow(conical_alpha*ratio, 2) + pow(conical_beta, 2)) -
-		(conical_alpha * ratio) - conical_beta);
+	double ratio = conical_alpha * (1 - (flow * inv_capacity));
+	return base_cost[id] * (2 + sqrt(ratio*ratio + conical_beta*conical_beta) - ratio - conical_beta);
+}
+
+/**
+Calculates the derivative of the nonlinear cost function for a given arc.
+
+Requires the arc ID, arc flow, and inverse arc capacity.
+
+Returns the derivative of the arc's cost with respect to its flow. This is zero for the arcs whose cost is treated as
+constant by arc_cost(), including zero-flow arcs, whose cost is taken to be the base cost.
+*/
+double NonlinearAssignment::arc_cost_derivative(int id, double flow, double inv_capacity)
+{
+	// Constant cost for zero-capacity, infinite-capacity, and zero-flow arcs
+	if ((inv_capacity >= INFINITY) || (inv_capacity == 0) || (flow == 0))
+		return 0.0;
+
+	/*
+	Otherwise, differentiate the conical congestion function, giving:
+		c'(x) = (c * alpha / u) * (1 - alpha * (1 - x/u) / sqrt((alpha * (1 - x/u))^2 + beta^2))
+	*/
+	double ratio = conical_alpha * (1 - (flow * inv_capacity));
+	return (base_cost[id] * conical_alpha * inv_capacity) * (1 - ratio / sqrt(ratio*ratio + conical_beta*conical_beta));
+}
+
+/**
+Performs the per-arc work of a Frank-Wolfe iteration in a single pass.
+
+Requires the step size, followed by references to the inverse capacity vector, the current solution (which is updated
+in place), the subproblem solution, the step target (the subproblem solution unless a conjugate method is in use), the
+arc cost vector, and the change pair, respectively. The arc costs must be those of the current solution, and are
+overwritten with those of the updated solution.
+
+Returns the error bound of the current solution, as in obj_error(), and sets the change pair to the maximum elementwise
+flow difference and the waiting time difference, as in solution_update().
+
+Computing the error bound, the convex combination, and the next iteration's costs separately would take three passes
+over the arcs, two of which evaluate the cost functions. Since the error bound only needs the current costs, which were
+computed at the end of the previous pass, a single pass over the contiguous flow, cost, and capacity arrays suffices.
+The arcs are divided into fixed blocks whose partial results are combined in order, so the results do not depend on the
+number of threads.
+*/
+double NonlinearAssignment::fused_update(double step, const vector<double> &inv_capacities,
+	pair<vector<double>, double> &current, const pair<vector<double>, double> &subproblem,
+	const pair<vector<double>, double> &target, vector<double> &arc_costs, pair<double, double> &change)
+{
+	int arc_count = arc_costs.size(); // number of arcs
+	int blocks = (arc_count + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK; // number of arc blocks
+	vector<double> block_error(blocks); // error bound terms of each block
+	vector<double> block_change(blocks); // maximum flow difference within each block
+	double * flows = current.first.data(); // current flows
+	const double * sub_flows = subproblem.first.data(); // subproblem flows
+	const double * target_flows = target.first.data(); // step target flows
+	const double * inv = inv_capacities.data(); // inverse capacities
+	double * costs = arc_costs.data(); // arc costs
+
+	parallel_for(0, blocks, [&](int b)
+	{
+		int first = b * REDUCTION_BLOCK; // first arc ID in block
+		int last = min(first + REDUCTION_BLOCK, arc_count); // one past the last arc ID in block
+		double err = 0.0;
+		double diff = 0.0;
+		for (int i = first; i < last; i++)
+		{
+			err += costs[i] * (flows[i] - sub_flows[i]);
+			double updated = (1 - step)*flows[i] + step*target_flows[i];
+			diff = max(abs(updated - flows[i]), diff);
+			flows[i] = updated;
+			costs[i] = arc_cost(i, updated, inv[i]);
+		}
+		block_error[b] = err;
+		block_change[b] = diff;
+	});
+
+	// Combine the block results along with the waiting time terms
+	double error = current.second - subproblem.second;
+	change.first = 0.0;
+	for (int b = 0; b < blocks; b++)
+	{
+		error += block_error[b];
+		change.first = max(block_change[b], change.first);
+	}
+	double waiting = (1 - step)*current.second + step*target.second;
+	change.second = abs(waiting - current.second);
+	current.second = waiting;
+
+	return abs(error);
+}
+
+/**
+Replaces the subproblem solution with the target point of a conjugate or bi-conjugate Frank-Wolfe direction.
+
+Requires references to the inverse capacity vector, the current solution, the subproblem solution (which is overwritten
+with the new target), the targets of the previous two iterations, the previous step size, and the iteration number,
+respectively.
+
+The ordinary Frank-Wolfe direction points from the current solution x toward the subproblem solution y. The conjugate
+methods instead point toward a convex combination s of y and the previous targets, chosen so that the new direction is
+conjugate to the previous direction(s) with respect to the Hessian H of the equilibrium objective at x. The waiting time
+term is linear, so H is the diagonal matrix of arc cost derivatives, and the waiting time of s is combined using the
+same weights as its flows.
+
+The conjugate method (CFW) uses the previous target s1:
+	s = a s1 + (1 - a) y, where a = (s1 - x)'H(y - x) / (s1 - x)'H(y - s1)
+with a limited to [0, CONJUGATE_MAX] so that s stays close enough to y to remain a descent direction.
+
+The bi-conjugate method (BFW) additionally uses the target s2 before that and the previous step size t:
+	s = b0 y + b1 s1 + b2 s2, where b0 = 1/(1 + m + n), b1 = n b0, b2 = m b0
+	d1 = s1 - x, d2 = t s1 - x + (1 - t) s2
+	m = -d2'H(y - x) / d2'H(s2 - s1)
+	n = -d1'H(y - x) / d1'H d1 + m t/(1 - t)
+with m and n limited to be nonnegative. It falls back on CFW during the second iteration and after any full step, and
+both fall back on the ordinary direction during the first iteration.
+*/
+void NonlinearAssignment::conjugate_target(const vector<double> &inv_capacities,
+	const pair<vector<double>, double> &current, pair<vector<double>, double> &next,
+	const pair<vector<double>, double> &target1, const pair<vector<double>, double> &target2, double step_previous,
+	int iteration)
+{
+	// Use the ordinary direction during the first iteration
+	if (iteration <= 1)
+		return;
+	bool biconjugate = ((fw_method == FW_BICONJUGATE) && (iteration > 2) && (step_previous < 1));
+
+	// Accumulate the Hessian products in a single pass over the congestible arcs
+	double num1 = 0.0, den1 = 0.0; // numerator and denominator involving the previous target
+	double num2 = 0.0, den2 = 0.0; // numerator and denominator involving the older target (BFW only)
+	for (int i = 0; i < Net->core_arcs.size(); i++)
+	{
+		double h = arc_cost_derivative(i, current.first[i], inv_capacities[i]); // diagonal Hessian element
+		if (h == 0)
+			continue;
+		double x = current.first[i];
+		double y = next.first[i];
+		double s1 = target1.first[i];
+		if (biconjugate == false)
+		{
+			num1 += h * (s1 - x) * (y - x);
+			den1 += h * (s1 - x) * (y - s1);
+		}
+		else
+		{
+			double s2 = target2.first[i];
+			double d1 = s1 - x;
+			double d2 = step_previous*s1 - x + (1 - step_previous)*s2;
+			num1 += h * d1 * (y - x);
+			den1 += h * d1 * d1;
+			num2 += h * d2 * (y - x);
+			den2 += h * d2 * (s2 - s1);
+		}
+	}
+
+	// Find the convex combination weights of the subproblem solution and the previous targets
+	double b0 = 1.0, b1 = 0.0, b2 = 0.0; // weights of y, s1, and s2
+	if (biconjugate == false)
+	{
+		double a = 0.0;
+		if (den1 != 0)
+			a = min(max(num1 / den1, 0.0), CONJUGATE_MAX);
+		b0 = 1 - a;
+		b1 = a;
+	}
+	else
+	{
+		double m = 0.0, n = 0.0;
+		if (den2 != 0)
+			m = max(-num2 / den2, 0.0);
+		if (den1 != 0)
+			n = max(-num1 / den1 + m*step_previous / (1 - step_previous), 0.0);
+		b0 = 1 / (1 + m + n);
+		b1 = n * b0;
+		b2 = m * b0;
+	}
+
+	// Combine the points
+	for (int i = 0; i < next.first.size(); i++)
+	{
+		next.first[i] = b0*next.first[i] + b1*target1.first[i];
+		if (b2 > 0)
+			next.first[i] += b2*target2.first[i];
+	}
+	next.second = b0*next.second + b1*target1.second;
+	if (b2 > 0)
+		next.second += b2*target2.second;
+}
+
+/**
+Chooses the Frank-Wolfe step size with an exact line search.
+
+Requires references to the inverse capacity vector, the current flow vector, the current waiting time, the next flow
+vector, and the next waiting time, respectively.
+
+Returns the step size in [0,1] which minimizes the equilibrium objective along the line from the current solution to the
+next solution.
+
+The equilibrium objective is the sum of the integrals of the arc cost functions plus the waiting time, which is linear.
+Its derivative along the direction d = (next - current) at step size t is
+	g(t) = (waiting_next - waiting_current) + sum_a c_a(x_a + t d_a) d_a
+which is nondecreasing since the arc costs are nondecreasing. Note that -g(0) is the quantity bounded by obj_error().
+
+The root of g is found by Newton's method safeguarded by bisection (see root_search()), using the derivative
+	g'(t) = sum_a c'_a(x_a + t d_a) d_a^2
+Only the congestible arcs with nonzero direction change from one evaluation to the next, so the rest are summed into a
+constant term once. The congestible arcs are then evaluated in a single fused pass that accumulates both g and g'. It is
+divided into fixed blocks which are summed in order, so the chosen step size does not depend on the thread count.
+*/
+double NonlinearAssignment::line_search(const vector<double> &inv_capacities, const vector<double> &flows_current,
+	double waiting_current, const vector<double> &flows_next, double waiting_next)
+{
+	// Separate the arcs with constant costs from the congestible arcs that move along the direction
+	double constant = waiting_next - waiting_current; // part of the directional derivative that does not depend on t
+	vector<int> moving; // congestible arcs with nonzero direction
+	for (int i = 0; i < Net->core_arcs.size(); i++)
+	{
+		double d = flows_next[i] - flows_current[i];
+		if (d == 0)
+			continue;
+		if ((inv_capacities[i] >= INFINITY) || (inv_capacities[i] == 0))
+			constant += arc_cost(i, flows_current[i], inv_capacities[i]) * d;
+		else
+			moving.push_back(i);
+	}
+	int blocks = (moving.size() + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK; // number of arc blocks
+	vector<pair<double, double>> partial(blocks); // directional derivative and its derivative for each block
+
+	// Evaluate the directional derivative and its derivative at a given step size in a single pass
+	auto derivative = [&](double t)
+	{
+		parallel_for(0, blocks, [&](int b)
+		{
+			int first = b * REDUCTION_BLOCK; // first position in block
+			int last = min(first + REDUCTION_BLOCK, (int) moving.size()); // one past the last position in block
+			double g = 0.0;
+			double dg = 0.0;
+			for (int j = first; j < last; j++)
+			{
+				int i = moving[j];
+				double d = flows_next[i] - flows_current[i];
+				double x = flows_current[i] + t*d;
+				g += arc_cost(i, x, inv_capacities[i]) * d;
+				dg += arc_cost_derivative(i, x, inv_capacities[i]) * d * d;
+			}
+			partial[b] = make_pair(g, dg);
+		});
+		pair<double, double> total = make_pair(constant, 0.0);
+		for (int b = 0; b < blocks; b++)
+		{
+			total.first += partial[b].first;
+			total.second += partial[b].second;
+		}
+		return total;
+	};
+
+	return root_search(derivative);
+}
+
+/**
+Finds the step size at which a nondecreasing directional derivative changes sign.
+
+Requires a function that returns the directional derivative and its own derivative at a given step size.
+
+Returns the step size in [0,1] at which the directional derivative is zero, or the endpoint of [0,1] whose directional
+derivative has the same sign as its opposite endpoint's, in which case the objective is minimized at that endpoint.
+
+The root is found by Newton's method, falling back on bisection whenever a Newton step would leave the interval known to
+contain the root.
+*/
+double NonlinearAssignment::root_search(const function<pair<double, double>(double)> &derivative)
+{
+	// Handle steps at either end of the interval
+	if (derivative(1.0).first <= 0)
+		return 1.0;
+	pair<double, double> value = derivative(0.0); // directional derivative and its derivative at the current step
+	if (value.first >= 0)
+		return 0.0;
+	double low = 0.0; // step sizes below this have negative directional derivative
+	double high = 1.0; // step sizes above this have positive directional derivative
+	double t = 0.0; // current step size
+
+	// Safeguarded Newton's method
+	for (int k = 0; (k < LINE_SEARCH_MAX) && (high - low > LINE_SEARCH_TOL); k++)
+	{
+		// Take a Newton step, or bisect if it would leave the bracketing interval
+		double t_next = (low + high) / 2;
+		if (value.second > 0)
+		{
+			double newton = t - value.first / value.second;
+			if ((newton > low) && (newton < high))
+				t_next = newton;
+		}
+		bool converged = (abs(t_next - t) <= LINE_SEARCH_TOL); // whether the step size has stopped changing
+		t = t_next;
+		if (converged == true)
+			break;
+
+		value = derivative(t);
+		if (value.first == 0)
+			break;
+		if (value.first < 0)
+			low = t;
+		else
+			high = t;
+	}
+
+	return t;
+}
+
+/**
+Records the progress of a single iteration for the convergence trace, if tracing is enabled.
+
+Requires the iteration number, the error bound, the flow/waiting time change pair, the step size, and the wall time of
+the iteration's constant-cost submodel call (in seconds). Values that do not apply are given as -1.
+*/
+void NonlinearAssignment::trace_iteration(int iteration, double error, const pair<double, double> &change, double step,
+	double submodel_time)
+{
+	if (trace == true)
+		trace_rows.push_back({ 1.0*iteration, error, change.first, change.second, step, submodel_time });
+}
+
+/**
+Appends the trace of the most recent evaluation to the trace file, if tracing is enabled. The first traced evaluation
+begins a new trace file.
+
+The stopping rule is determined from the final recorded iteration, checking the rules in order of precedence:
+cancellation (STOP_CANCEL), early termination (STOP_BOUND), the error bound (STOP_ERROR), the solution change
+(STOP_CHANGE), and otherwise the iteration cutoff (STOP_CUTOFF). It is written in the final row of the evaluation, and
+every other row has a stopping rule of 0.
+*/
+void NonlinearAssignment::trace_finish()
+{
+	if (trace == false)
+		return;
+	trace_evaluation++;
+
+	// Determine which stopping rule ended the evaluation
+	const vector<double> &last = trace_rows.back(); // final recorded iteration
+	int stop = STOP_CUTOFF;
+	if (abandoned == true)
+		stop = STOP_CANCEL;
+	else if (verdict != FEAS_UNKNOWN)
+		stop = STOP_BOUND;
+	else if ((last[1] >= 0) && (last[1] <= error_tol))
+		stop = STOP_ERROR;
+	else if ((last[2] >= 0) && (last[2] <= flow_tol) && (last[3] <= waiting_tol))
+		stop = STOP_CHANGE;
+
+	// Begin a new trace file with the first traced evaluation, and append to it afterwards
+	ofstream trace_file;
+	if (trace_evaluation == 1)
+		trace_file.open(FILE_BASE + TRACE_FILE);
+	else
+		trace_file.open(FILE_BASE + TRACE_FILE, ios_base::app);
+	if (trace_file.is_open())
+	{
+		if (trace_evaluation == 1)
+			trace_file << "Evaluation\tFidelity\tIteration\tError\tFlow_Change\tWaiting_Change\tStep\tSubmodel_Time\t"
+				"Stop" << endl;
+		trace_file << fixed << setprecision(15);
+		for (int i = 0; i < trace_rows.size(); i++)
+		{
+			trace_file << trace_evaluation << '\t' << fidelity << '\t' << (int) trace_rows[i][0];
+			for (int j = 1; j < trace_rows[i].size(); j++)
+				trace_file << '\t' << trace_rows[i][j];
+			trace_file << '\t' << ((i + 1 == trace_rows.size()) ? stop : 0) << endl;
+		}
+		trace_file.close();
+	}
+	else
+		cout << "Trace file failed to open." << endl;
+}
+
+/**
+Checks whether the user cost of a solution appears to lie on one side of the early termination threshold.
+
+Requires a flow/waiting pair and an error bound on its equilibrium objective value.
+
+Returns true if the interval extending the gap margin times the error bound to either side of the solution's user cost
+lies entirely above or below the user cost threshold, in which case the verdict attribute is set to FEAS_FALSE or
+FEAS_TRUE, respectively. Returns false otherwise, or if early termination is disabled.
+
+The error bound is measured in the same units as the user cost, since both are sums of flows times arc costs plus the
+waiting time. It bounds how far the equilibrium objective can still fall, but since the user cost is a different
+function of the flows the interval is a heuristic rather than a bound, and is only as reliable as the gap margin makes
+it. It is therefore used only for screening: a FEAS_TRUE verdict is confirmed by a full assignment without early
+termination before the search accepts the solution (see Constraint::verify()). Most solutions lie far from the
+threshold, and these are decided within a few iterations.
+*/
+bool NonlinearAssignment::bound_reached(const pair<vector<double>, double> &sol, double error)
+{
+	// Skip check if early termination is disabled
+	if ((uc_threshold >= INFINITY) || (gap_margin <= 0))
+		return false;
+
+	// Calculate user cost of solution
+	double user_cost = uc_waiting_weight * sol.second;
+	for (int i = 0; i < uc_arc_weight.size(); i++)
+		user_cost += uc_arc_weight[i] * sol.first[i];
+
+	// Compare interval to threshold
+	if (user_cost - gap_margin*error > uc_threshold)
+		verdict = FEAS_FALSE;
+	else if (user_cost + gap_margin*error <= uc_threshold)
+		verdict = FEAS_TRUE;
+	else
+		return false;
+	return true;
 }
 
 /**
 Calculates an error bound for the current objective value based on the difference between consecutive solutions.
 
-Requires references to the capacity vector, the current flow vector, the current waiting time, the next flow vector, and
-the next waiting time, respectively.
+Requires references to the inverse capacity vector, the current flow vector, the current waiting time, the next flow
+vector, and the next waiting time, respectively.
 
 Returns an upper bound for the absolute error in the current solution.
 
@@ -180,13 +785,13 @@ objective values of the previous solutions. Since our algorithm never explicitly
 values of the linearized objective), we instead use a looser but more easily calculated bound that involves the
 difference between consecutive linearized objective values.
 */
-double NonlinearAssignment::obj_error(const vector<double> &capacities, const vector<double> &flows_old,
+double NonlinearAssignment::obj_error(const vector<double> &inv_capacities, const vector<double> &flows_old,
 	double waiting_old, const vector<double> &flows_new, double waiting_new)
 {
 	// Calculate error term-by-term
 	double total = waiting_old - waiting_new;
 	for (int i = 0; i < Net->core_arcs.size(); i++)
-		total += arc_cost(Net->core_arcs[i]->id, flows_old[i], capacities[i]) * (flows_old[i] - flows_new[i]);
+		total += arc_cost(i, flows_old[i], inv_capacities[i]) * (flows_old[i] - flows_new[i]);
 
 	return abs(total);
 }
@@ -0,0 +1,184 @@
+/// Simplicial decomposition methods of the nonlinear cost assignment model class.
+
+#include "assignment.hpp"
+
+/**
+Nonlinear cost assignment model evaluation by simplicial decomposition.
+
+Requires a fleet size vector, the inverse capacity vector, and an initial solution produced by the constant-cost
+submodel.
+
+Returns a pair containing a vector of flow values and a waiting time scalar.
+
+Each solution of the constant-cost submodel is an extreme point (a combination of single-destination hyperpaths) of the
+feasible set of the nonlinear model. Rather than discarding them after a single step as the Frank-Wolfe algorithm does,
+simplicial decomposition keeps them in a pool of columns and represents the current solution as a convex combination of
+the whole pool. Each outer iteration calls the expensive all-destination submodel once, at the current solution's
+costs, to generate a new column, and then solves the restricted master problem of minimizing the equilibrium objective
+over all convex combinations of the pool (see restricted_master()). Solving the master problem requires only arithmetic
+on the pooled flow vectors.
+
+The stopping rules are the same as for the Frank-Wolfe algorithm (including early termination), with the error bound
+measured against each new column and the solution change measured across each outer iteration.
+
+At most SIMPLICIAL_POOL columns are kept. Columns whose weights drop to zero are removed first, and if the pool is still
+too large its two lowest-weight columns are replaced by their weighted combination, which leaves the current solution
+unchanged.
+*/
+pair<vector<double>, double> NonlinearAssignment::simplicial_decomposition(const vector<int> &fleet,
+	const vector<double> &inv_capacities, const pair<vector<double>, double> &initial_sol)
+{
+	// Initialize the pool with the initial solution
+	vector<pair<vector<double>, double>> pool(1, initial_sol); // flow/waiting pairs of the pooled columns
+	vector<double> weights(1, 1.0); // convex combination weight of each column
+	pair<vector<double>, double> sol_current = initial_sol; // current flow/waiting pair
+	int iteration = 0; // current outer iteration number
+	double error = INFINITY; // current solution error bound
+	pair<double, double> change = make_pair(INFINITY, INFINITY); // flow/waiting time differences betw outer iterations
+	vector<double> arc_costs(Net->core_arcs.size()); // arc costs at the current solution
+	verdict = FEAS_UNKNOWN;
+
+	while ((cancelled() == false) && (iteration < max_iterations) && (error > error_tol) &&
+		((change.first > flow_tol) || (change.second > waiting_tol)))
+	{
+		iteration++;
+		cout << '.';
+
+		// Generate a new column by solving the constant-cost model at the current costs
+		for_each(Net->core_arcs.begin(), Net->core_arcs.end(), [&](Arc * a)
+		{
+			arc_costs[a->id] = arc_cost(a->id, sol_current.first[a->id], inv_capacities[a->id]);
+		});
+		auto submodel_start = chrono::steady_clock::now(); // submodel timer
+		pair<vector<double>, double> column = Submodel->calculate(fleet, arc_costs);
+		double submodel_time = chrono::duration<double>(chrono::steady_clock::now() - submodel_start).count();
+		if (cancelled() == true)
+			// Abandon the iteration if the solve was cut short by cancellation
+			break;
+		error = obj_error(inv_capacities, sol_current.first, sol_current.second, column.first, column.second);
+		if (bound_reached(sol_current, error) == true)
+		{
+			trace_iteration(iteration, error, make_pair(-1.0, -1.0), -1, submodel_time);
+			break;
+		}
+		pool.push_back(column);
+		weights.push_back(0.0);
+
+		// Reoptimize the weights over the pool, more precisely as the error bound shrinks
+		pair<vector<double>, double> sol_previous = sol_current; // solution before this iteration
+		restricted_master(inv_capacities, pool, weights, sol_current, max(error_tol, SIMPLICIAL_MASTER_GAP*error));
+
+		// Remove unused columns, then merge the lightest columns until the pool fits
+		for (int j = pool.size() - 1; j >= 0; j--)
+		{
+			if ((weights[j] <= 0) && (pool.size() > 1))
+			{
+				pool.erase(pool.begin() + j);
+				weights.erase(weights.begin() + j);
+			}
+		}
+		while (pool.size() > SIMPLICIAL_POOL)
+		{
+			// Find the two lowest-weight columns
+			int first = 0; // index of lowest-weight column
+			for (int j = 1; j < pool.size(); j++)
+				if (weights[j] < weights[first])
+					first = j;
+			int second = (first == 0) ? 1 : 0; // index of second-lowest-weight column
+			for (int j = 0; j < pool.size(); j++)
+				if ((j != first) && (weights[j] < weights[second]))
+					second = j;
+
+			// Replace the second by the weighted combination of both and remove the first
+			double total = weights[first] + weights[second];
+			double share = weights[first] / total; // fraction of the combination contributed by the first column
+			for (int i = 0; i < pool[second].first.size(); i++)
+				pool[second].first[i] = share*pool[first].first[i] + (1 - share)*pool[second].first[i];
+			pool[second].second = share*pool[first].second + (1 - share)*pool[second].second;
+			weights[second] = total;
+			pool.erase(pool.begin() + first);
+			weights.erase(weights.begin() + first);
+		}
+
+		// Measure the change across the outer iteration
+		change = make_pair(0.0, abs(sol_current.second - sol_previous.second));
+		for (int i = 0; i < sol_current.first.size(); i++)
+			change.first = max(abs(sol_current.first[i] - sol_previous.first[i]), change.first);
+		trace_iteration(iteration, error, change, -1, submodel_time);
+	}
+
+	return sol_current;
+}
+
+/**
+Solves the restricted master problem of simplicial decomposition.
+
+Requires references to the inverse capacity vector, the pool of columns, their weights, and the current solution (which
+must be the weighted combination of the pool), followed by a stopping tolerance. The weights and the current solution
+are updated in place.
+
+Returns the number of master iterations performed.
+
+The master problem minimizes the equilibrium objective over the convex combinations of the pooled columns. Its gradient
+with respect to a column's weight is that column's total cost (including waiting time) at the current solution's arc
+costs. Each master iteration makes a pairwise step, shifting weight from the costliest column in use to the cheapest
+column, with the step length chosen by the exact line search along that direction. The iterations stop once the cost
+difference between these two columns falls below the tolerance, or after SIMPLICIAL_MASTER iterations.
+
+The outer loop sets the tolerance to a fraction of its current error bound, since there is little point in solving the
+master problem far more precisely than the pool can represent the equilibrium.
+*/
+int NonlinearAssignment::restricted_master(const vector<double> &inv_capacities,
+	const vector<pair<vector<double>, double>> &pool, vector<double> &weights,
+	pair<vector<double>, double> &sol_current, double tolerance)
+{
+	int iteration = 0;
+	vector<double> arc_costs(Net->core_arcs.size()); // arc costs at the current solution
+	vector<double> column_costs(pool.size()); // total cost of each column at the current arc costs
+
+	for (; iteration < SIMPLICIAL_MASTER; iteration++)
+	{
+		// Evaluate the column costs at the current solution
+		for_each(Net->core_arcs.begin(), Net->core_arcs.end(), [&](Arc * a)
+		{
+			arc_costs[a->id] = arc_cost(a->id, sol_current.first[a->id], inv_capacities[a->id]);
+		});
+		parallel_for(0, (int) pool.size(), [&](int j)
+		{
+			double total = pool[j].second;
+			for (int i = 0; i < arc_costs.size(); i++)
+				total += arc_costs[i] * pool[j].first[i];
+			column_costs[j] = total;
+		});
+
+		// Find the cheapest column and the costliest column in use
+		int best = 0; // index of cheapest column
+		int worst = -1; // index of costliest column with positive weight
+		for (int j = 0; j < pool.size(); j++)
+		{
+			if (column_costs[j] < column_costs[best])
+				best = j;
+			if ((weights[j] > 0) && ((worst < 0) || (column_costs[j] > column_costs[worst])))
+				worst = j;
+		}
+		if ((worst < 0) || (column_costs[worst] - column_costs[best] <= tolerance))
+			break;
+
+		// Line search along the pairwise direction, moving at most all of the costliest column's weight
+		pair<vector<double>, double> target = sol_current; // solution with all weight moved
+		for (int i = 0; i < target.first.size(); i++)
+			target.first[i] += weights[worst] * (pool[best].first[i] - pool[worst].first[i]);
+		target.second += weights[worst] * (pool[best].second - pool[worst].second);
+		double step = line_search(inv_capacities, sol_current.first, sol_current.second, target.first, target.second);
+		if (step <= 0)
+			break;
+
+		// Update the weights and the solution
+		double moved = step * weights[worst]; // weight shifted between the two columns
+		weights[best] += moved;
+		weights[worst] = (step >= 1) ? 0.0 : weights[worst] - moved;
+		solution_update(1 - step, sol_current.first, sol_current.second, target.first, target.second);
+	}
+
+	return iteration;
+}
@@ -0,0 +1,57 @@
+/**
+Cooperative cancellation of long-running evaluations.
+
+The objective and constraint evaluations can each take a long time, so rather than waiting for them to finish, a stop
+request or an expired deadline is signaled through a token that the evaluators check between their units of work (single
+destinations, single population centers, and single Frank-Wolfe iterations). An evaluator that finds its token cancelled
+returns as soon as possible, and its caller is responsible for discarding the incomplete result.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+/**
+Cancellation token shared between the search and its evaluators.
+
+A stop request is permanent, and may be made asynchronously by the stop request signal handler. A deadline applies only
+to the constraint evaluations, and is started and cleared around each one by the constraint object.
+*/
+struct CancelToken
+{
+	// Public attributes
+	atomic<bool> stop{ false }; // whether a stop has been requested
+	double deadline_seconds = 0.0; // wall time allowed for each constraint evaluation (0 for no deadline)
+	bool deadline_set = false; // whether a deadline is currently running
+	chrono::steady_clock::time_point deadline; // time at which the running evaluation is abandoned
+
+	// Public methods
+	void request_stop() // requests that all evaluations stop (safe to call from a signal handler)
+	{
+		stop = true;
+	}
+	bool stop_requested() const // returns whether a stop has been requested
+	{
+		return stop.load();
+	}
+	void start_deadline(int evaluations) // starts the deadline for a number of evaluations carried out together
+	{
+		deadline_set = (deadline_seconds > 0);
+		if (deadline_set == true)
+			deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+				chrono::duration<double>(deadline_seconds * evaluations));
+	}
+	void clear_deadline() // stops the running deadline
+	{
+		deadline_set = false;
+	}
+	bool cancelled() const // returns whether the running evaluation should stop
+	{
+		if (stop_requested() == true)
+			return true;
+		return ((deadline_set == true) && (chrono::steady_clock::now() >= deadline));
+	}
+};
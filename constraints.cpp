@@ -5,7 +5,7 @@ Constraint::Constraint(Network * net_in)
 {
 	Net = net_in;
 	stop_size = Net->stop_nodes.size();
-	sol_pair.first.resize(Net->core_arcs.size(), 0.0);
+	context.sol_pair.first.resize(Net->core_arcs.size(), 0.0);
 
 	// Attempt to read initial flow file (if file is not present, it will simply remain initialized as the zero vector)
 	ifstream fl_file;
@@ -31,7 +31,14 @@ Constraint::Constraint(Network * net_in)
 			getline(stream, piece, '\t'); // Arc ID
 			int id = stoi(piece);
 			getline(stream, piece, '\t'); // Flow
-			sol_pair.first[id] = stod(piece);
+			if (Net->arc_map.size() > 0)
+			{
+				// Flows on a coarse network are accumulated onto the arcs that replaced the original arcs
+				if (Net->arc_map[id] != NO_ID)
+					context.sol_pair.first[Net->arc_map[id]] += stod(piece);
+			}
+			else
+				context.sol_pair.first[id] = stod(piece);
 		}
 
 		fl_file.close();
@@ -39,6 +46,7 @@ Constraint::Constraint(Network * net_in)
 
 	// Initialize assignment model object
 	Assignment = new NonlinearAssignment(net_in);
+	context.Assignment = Assignment;
 
 	// Read constraint data
 	ifstream us_file;
@@ -76,6 +84,14 @@ Constraint::Constraint(Network * net_in)
 				walking_weight = stod(value);
 			if (count == 6)
 				waiting_weight = stod(value);
+			if (count == 7)
+				sample_fraction = stod(value);
+			if (count == 8)
+				sample_z = stod(value);
+			if (count == 9)
+				gap_margin = stod(value);
+			if (count == 10)
+				free_flow = (stoi(value) == 1);
 
 			// Handle the event of an unspecified initial user cost
 			if (initial_user_cost < 0)
@@ -92,12 +108,38 @@ Constraint::Constraint(Network * net_in)
 		cout << "Constraint file failed to open." << endl;
 		exit(FILE_NOT_FOUND);
 	}
+
+	// Set up the destination sample for screening
+	if (sample_fraction > 0)
+		build_sample();
+
+	// Skip a free-flow prescreen that cannot be scaled to the user cost
+	if ((free_flow == true) && (waiting_weight <= 0))
+	{
+		cout << "Free-flow prescreen requires a positive waiting time weight. The prescreen has been turned off." <<
+			endl;
+		free_flow = false;
+	}
+
+	// Give the assignment model the user cost weights for early termination and the free-flow prescreen
+	Assignment->gap_margin = gap_margin;
+	if ((gap_margin > 0) || (free_flow == true))
+	{
+		Assignment->uc_arc_weight.assign(Net->core_arcs.size(), 0.0);
+		for (int i = 0; i < Net->line_arcs.size(); i++)
+			Assignment->uc_arc_weight[Net->line_arcs[i]->id] = riding_weight * Net->line_arcs[i]->cost;
+		for (int i = 0; i < Net->walking_arcs.size(); i++)
+			Assignment->uc_arc_weight[Net->walking_arcs[i]->id] = walking_weight * Net->walking_arcs[i]->cost;
+		Assignment->uc_waiting_weight = waiting_weight;
+	}
 }
 
-/// Constraint object destructor deletes the nonlinear model object created by the constructor.
+/// Constraint object destructor deletes the nonlinear model objects created by the constructor and set_concurrency().
 Constraint::~Constraint()
 {
 	delete Assignment;
+	for (int c = 0; c < contexts.size(); c++)
+		delete contexts[c].Assignment;
 }
 
 /**
@@ -113,45 +155,787 @@ produced by the assignment model.
 
 Note that this entire process is skipped if the user cost percentage increase parameter is negative, which is how the
 user can specify in the input files to ignore the user cost constraints.
+
+If a sample fraction has been specified, the solution is first screened using only a sample of the destinations (see
+sample_user_cost()). If the resulting confidence interval for the total user cost lies entirely on one side of the bound
+then the sampled estimate decides the solution's feasibility, and its estimated user cost components are returned. Only
+solutions whose interval contains the bound go on to the full assignment model. The source attribute records which of
+the two produced the returned result.
+
+If a gap margin has been specified, the full assignment model is also allowed to stop as soon as the user cost of its
+current solution, give or take the gap margin times its error bound, lies entirely on one side of the bound (see
+NonlinearAssignment::bound_reached()). The solution's feasibility is then decided by that interval, and the source
+attribute records this. Since the interval is only a heuristic, solutions found feasible this way must be confirmed by
+verify() before they are accepted.
+
+If the free-flow prescreen is enabled it comes before everything else, and rejects any solution whose free-flow user
+cost lower bound (see free_flow_user_cost()) already exceeds the bound.
+
+Both assignment models are warm-started from the flows returned by warm_start(), and if flow snapshots are enabled then
+the full model's flows are stored for later warm starts.
 */
 pair<int, vector<double>> Constraint::calculate(const vector<int> &sol)
 {
+	pair<int, vector<double>> result = calculate_batch(vector<vector<int>>(1, sol))[0];
+	source = sources[0];
+	return result;
+}
+
+/**
+Evaluates the constraint functions for several solutions together.
+
+Requires a vector of solution vectors.
+
+Returns a vector of feasibility result/constraint function element pairs (see calculate()), one for each solution, and
+sets the sources attribute to the source of each one.
+
+If concurrent evaluation has been selected (see set_concurrency()) then the solutions are evaluated concurrently (see
+calculate_concurrent()). Otherwise every solution is screened in turn (see screen()), and all of the solutions that
+still require the full assignment model are then evaluated together (see NonlinearAssignment::calculate_lockstep()),
+all warm-started from the same flows. Their results are the same as if they were evaluated one at a time, except that
+each one would otherwise have been warm-started from the one before it unless a parent has been set (see set_parent()).
+
+If a cancellation token has been set then the evaluations stop as soon as a stop is requested or the deadline passes.
+The deadline is started when this method is called, and is extended by its full length for each solution after the
+first, since solutions evaluated together share the wall time. Any solution whose evaluation is cut short is given an
+unknown feasibility status and the CON_SOURCE_ABANDONED source, and its results must be discarded by the caller.
+*/
+vector<pair<int, vector<double>>> Constraint::calculate_batch(const vector<vector<int>> &sols)
+{
+	vector<pair<int, vector<double>>> results(sols.size()); // feasibility/constraint pair of each solution
+	sources.assign(sols.size(), CON_SOURCE_FULL);
+
+	// Skip process if user cost increase parameter is negative
+	if (uc_percent_increase < 0)
+	{
+		for (int i = 0; i < sols.size(); i++)
+			results[i] = make_pair(FEAS_UNKNOWN, vector<double>(UC_COMPONENTS, FEAS_UNKNOWN));
+		return results;
+	}
+
+	// Evaluate the solutions concurrently instead (if selected)
+	if ((contexts.size() > 0) && (sols.size() > 1))
+		return calculate_concurrent(sols);
+
+	double bound = (1 + uc_percent_increase)*initial_user_cost; // user cost upper bound
+	fidelity = Assignment->fidelity;
+	if (Cancel != NULL)
+		Cancel->start_deadline(sols.size());
+
+	// Screen each solution, collecting those that still require the full assignment model
+	vector<vector<int>> full_sols; // solutions that require the full assignment model
+	vector<int> full_index; // position of each of these solutions in the solution list
+	for (int i = 0; i < sols.size(); i++)
+	{
+		results[i] = screen(sols[i], context, bound);
+		sources[i] = context.source;
+		if (sources[i] == CON_SOURCE_FULL)
+		{
+			full_sols.push_back(sols[i]);
+			full_index.push_back(i);
+		}
+	}
+
+	// Feed solutions to assignment model to calculate flow vectors, stopping each early once its feasibility is clear
+	Assignment->uc_threshold = bound;
+	vector<pair<vector<double>, double>> assigned = Assignment->calculate_lockstep(full_sols, warm_start(context));
+	Assignment->uc_threshold = INFINITY;
+
+	for (int k = 0; k < full_index.size(); k++)
+	{
+		int i = full_index[k]; // position in the solution list
+		if (Assignment->lockstep_abandoned[k] == true)
+		{
+			// Discard the results of abandoned evaluations
+			sources[i] = CON_SOURCE_ABANDONED;
+			continue;
+		}
+		context.sol_pair.first.swap(assigned[k].first);
+		context.sol_pair.second = assigned[k].second;
+		if (snapshots_on == true)
+			store_snapshot(sols[i], context.sol_pair);
+		results[i] = full_result(context.sol_pair, Assignment->lockstep_verdicts[k], bound);
+		if (Assignment->lockstep_verdicts[k] != FEAS_UNKNOWN)
+			sources[i] = CON_SOURCE_BOUND;
+	}
+
+	if (Cancel != NULL)
+		Cancel->clear_deadline();
+	return results;
+}
+
+/**
+Evaluates the constraint functions for several solutions concurrently.
+
+Requires a vector of solution vectors.
+
+Returns a vector of feasibility result/constraint function element pairs (see calculate()), one for each solution, and
+sets the sources attribute to the source of each one.
+
+Each worker task is given its own evaluation context, and repeatedly claims the next unevaluated solution and evaluates
+it from start to finish (see evaluate()). Each assignment's constant-cost submodel then runs on a single worker, so
+this trades the parallelism within each evaluation for parallelism between them. This pays off on small networks, whose
+submodels have too few destinations to keep every processor busy until the end of each solve.
+
+Each context is warm-started from the parent's flows (see set_parent()) if they are stored, or otherwise from its own
+most recent full assignment, so the results match those of calculate_batch() only to within the assignment tolerances.
+The deadline is extended by its full length for every solution after the first that each context has to evaluate.
+Evaluations made in the contexts are not traced.
+*/
+vector<pair<int, vector<double>>> Constraint::calculate_concurrent(const vector<vector<int>> &sols)
+{
+	vector<pair<int, vector<double>>> results(sols.size()); // feasibility/constraint pair of each solution
+	sources.assign(sols.size(), CON_SOURCE_FULL);
+	double bound = (1 + uc_percent_increase)*initial_user_cost; // user cost upper bound
+	fidelity = Assignment->fidelity;
+	int workers = min((int) contexts.size(), (int) sols.size()); // number of worker tasks
+	if (Cancel != NULL)
+		Cancel->start_deadline((sols.size() + workers - 1) / workers);
+
+	// Evaluate all solutions in parallel, with each worker claiming the next solution in order
+	reader_writer_lock snapshot_lock; // lock for the stored snapshots
+	atomic<int> next(0); // position of the next unclaimed solution
+	parallel_for(0, workers, [&](int c)
+	{
+		for (int i = next.fetch_add(1); i < sols.size(); i = next.fetch_add(1))
+		{
+			results[i] = evaluate(sols[i], contexts[c], bound);
+			sources[i] = contexts[c].source;
+			if ((snapshots_on == true) && ((sources[i] == CON_SOURCE_FULL) || (sources[i] == CON_SOURCE_BOUND)))
+			{
+				snapshot_lock.lock();
+				store_snapshot(sols[i], contexts[c].sol_pair);
+				snapshot_lock.unlock();
+			}
+		}
+	});
+
+	if (Cancel != NULL)
+		Cancel->clear_deadline();
+	return results;
+}
+
+/**
+Screens a solution using the free-flow prescreen and the sampled estimate, if they are enabled.
+
+Requires a solution vector, the evaluation context to use, and the user cost bound.
+
+Returns a feasibility result/constraint function element pair (see calculate()), and sets the context's source to the
+screen that decided the solution's feasibility. If neither screen was decisive then the source is CON_SOURCE_FULL, and
+the returned pair should be replaced by the full assignment's result. If the sampled assignment was abandoned then the
+source is CON_SOURCE_ABANDONED and the feasibility is unknown.
+*/
+pair<int, vector<double>> Constraint::screen(const vector<int> &sol, EvaluationContext &ctx, double bound)
+{
+	pair<int, vector<double>> unknown = make_pair(FEAS_UNKNOWN, vector<double>(UC_COMPONENTS, FEAS_UNKNOWN));
+
+	// Reject solution if even its lower bound violates the bound
+	if (free_flow == true)
+	{
+		vector<double> free_ucc = free_flow_user_cost(sol, ctx);
+		if (riding_weight*free_ucc[0] + walking_weight*free_ucc[1] + waiting_weight*free_ucc[2] > bound)
+		{
+			ctx.source = CON_SOURCE_FREE_FLOW;
+			return make_pair(FEAS_FALSE, free_ucc);
+		}
+	}
+
+	// Screen solution using the sampled estimate, if it is clearly on one side of the bound
+	if (sample_fraction > 0)
+	{
+		vector<double> sample_ucc = sample_user_cost(sol, ctx);
+		ctx.source = CON_SOURCE_SAMPLE;
+		if (ctx.Assignment->abandoned == true)
+		{
+			ctx.source = CON_SOURCE_ABANDONED;
+			return unknown;
+		}
+		if (ctx.uc_estimate - ctx.uc_half_width > bound)
+			return make_pair(FEAS_FALSE, sample_ucc);
+		if (ctx.uc_estimate + ctx.uc_half_width <= bound)
+			return make_pair(FEAS_TRUE, sample_ucc);
+	}
+
+	ctx.source = CON_SOURCE_FULL;
+	return unknown;
+}
+
+/**
+Evaluates the constraint functions for a single solution in a given evaluation context.
+
+Requires a solution vector, the evaluation context to use, and the user cost bound.
+
+Returns a feasibility result/constraint function element pair (see calculate()), and sets the context's source.
+
+The solution is screened (see screen()), and if that is not decisive then the context's assignment model is run,
+stopping early once its feasibility is clear. Only the context and its own assignment model are changed, so evaluations
+in different contexts can safely run at the same time.
+*/
+pair<int, vector<double>> Constraint::evaluate(const vector<int> &sol, EvaluationContext &ctx, double bound)
+{
+	pair<int, vector<double>> result = screen(sol, ctx, bound); // screening result
+	if (ctx.source != CON_SOURCE_FULL)
+		return result;
+
+	// Feed solution to assignment model to calculate flow vector, stopping early once its feasibility is clear
+	ctx.Assignment->uc_threshold = bound;
+	pair<vector<double>, double> assigned = ctx.Assignment->calculate(sol, warm_start(ctx));
+	ctx.Assignment->uc_threshold = INFINITY;
+	if (ctx.Assignment->abandoned == true)
+	{
+		ctx.source = CON_SOURCE_ABANDONED;
+		return result;
+	}
+	ctx.sol_pair.first.swap(assigned.first);
+	ctx.sol_pair.second = assigned.second;
+	if (ctx.Assignment->verdict != FEAS_UNKNOWN)
+		ctx.source = CON_SOURCE_BOUND;
+
+	return full_result(ctx.sol_pair, ctx.Assignment->verdict, bound);
+}
+
+/**
+Evaluates the constraint functions for a single solution using a full assignment at tight tolerances.
+
+Requires a solution vector.
+
+Returns a feasibility result/constraint function element pair (see calculate()), and sets the source and fidelity
+attributes.
+
+This is meant for confirming that a solution is feasible before a move to it is accepted. The free-flow prescreen, the
+sampled estimate, and early termination are all skipped, since they only estimate which side of the bound the user cost
+lies on, and the tight tolerance profile is used whatever the current profile is (which is restored afterwards). The
+evaluation can still be abandoned if it is cancelled.
+*/
+pair<int, vector<double>> Constraint::verify(const vector<int> &sol)
+{
+	pair<int, vector<double>> unknown = make_pair(FEAS_UNKNOWN, vector<double>(UC_COMPONENTS, FEAS_UNKNOWN));
+	source = CON_SOURCE_FULL;
+	fidelity = FIDELITY_TIGHT;
+
 	// Skip process if user cost increase parameter is negative
 	if (uc_percent_increase < 0)
-		return make_pair(FEAS_UNKNOWN, vector<double>(UC_COMPONENTS, FEAS_UNKNOWN));
+		return unknown;
+
+	double bound = (1 + uc_percent_increase)*initial_user_cost; // user cost upper bound
+	int level = Assignment->fidelity; // tolerance profile to restore afterwards
+	Assignment->set_fidelity(FIDELITY_TIGHT);
+	if (Cancel != NULL)
+		Cancel->start_deadline(1);
+
+	// Feed solution to assignment model to calculate flow vector, without early termination
+	Assignment->uc_threshold = INFINITY;
+	pair<vector<double>, double> assigned = Assignment->calculate(sol, warm_start(context));
+	Assignment->set_fidelity(level);
+	if (Cancel != NULL)
+		Cancel->clear_deadline();
+	if (Assignment->abandoned == true)
+	{
+		source = CON_SOURCE_ABANDONED;
+		return unknown;
+	}
+	context.sol_pair.first.swap(assigned.first);
+	context.sol_pair.second = assigned.second;
+	if (snapshots_on == true)
+		store_snapshot(sol, context.sol_pair);
 
-	// Feed solution to assignment model to calculate flow vector
-	sol_pair = Assignment->calculate(sol, sol_pair);
+	return full_result(context.sol_pair, FEAS_UNKNOWN, bound);
+}
+
+/**
+Finds the feasibility result and constraint function elements of a full assignment.
 
+Requires a flow vector/waiting time pair produced by the assignment model, the assignment's early termination verdict,
+and the user cost bound.
+
+Returns a feasibility result/constraint function element pair (see calculate()). The feasibility is decided by comparing
+the total user cost to the bound, unless early termination has already decided it.
+*/
+pair<int, vector<double>> Constraint::full_result(const pair<vector<double>, double> &assigned, int verdict,
+	double bound)
+{
 	// Calculate user cost components
-	vector<double> ucc = user_cost_components();
+	vector<double> ucc = user_cost_components(assigned);
 
 	// Calculate total user cost and compare to the bound to determine feasibility
 	double total_user_cost = riding_weight*ucc[0] + walking_weight*ucc[1] + waiting_weight*ucc[2];
 	int feas = FEAS_TRUE;
-	if (total_user_cost > (1 + uc_percent_increase)*initial_user_cost)
+	if (total_user_cost > bound)
 		feas = FEAS_FALSE;
+	if (verdict != FEAS_UNKNOWN)
+		feas = verdict;
 
 	return make_pair(feas, ucc);
 }
 
+/**
+Rescales the user cost bound to this object's network.
+
+Requires a reference solution vector, whose feasibility bound is defined by the initial user cost.
+
+The initial user cost is replaced by the user cost of the reference solution on this object's network. This is meant for
+coarse networks, whose user costs are not directly comparable to those of the original network, so that their user cost
+bound instead limits the relative increase over the reference solution.
+*/
+void Constraint::calibrate(const vector<int> &sol)
+{
+	context.sol_pair = Assignment->calculate(sol, context.sol_pair);
+	vector<double> ucc = user_cost_components(context.sol_pair);
+	initial_user_cost = riding_weight*ucc[0] + walking_weight*ucc[1] + waiting_weight*ucc[2];
+}
+
+/**
+Sets the tolerance profile used by the assignment model for future evaluations.
+
+Requires a profile code (FIDELITY_TIGHT or FIDELITY_LOOSE). See NonlinearAssignment::set_fidelity().
+*/
+void Constraint::set_fidelity(int level)
+{
+	Assignment->set_fidelity(level);
+	for (int c = 0; c < contexts.size(); c++)
+		contexts[c].Assignment->set_fidelity(level);
+}
+
+/**
+Sets the cancellation token used by this object and its assignment models.
+
+Requires a pointer to the token (NULL to make evaluations uncancellable).
+*/
+void Constraint::set_cancel(CancelToken * token)
+{
+	Cancel = token;
+	Assignment->Cancel = token;
+	Assignment->Submodel->Cancel = token;
+	for (int c = 0; c < contexts.size(); c++)
+	{
+		contexts[c].Assignment->Cancel = token;
+		contexts[c].Assignment->Submodel->Cancel = token;
+	}
+}
+
+/**
+Chooses between parallelism within each evaluation and parallelism between evaluations.
+
+Requires a concurrency mode code (CONCURRENCY_OFF, CONCURRENCY_AUTO, or CONCURRENCY_ON).
+
+Each constant-cost submodel solve is parallelized over its destinations, but must wait for its slowest destination at
+the end. On a small network there are too few destinations per processor to hide this wait, so it is better to evaluate
+several solutions at once with each submodel solved by a single worker (see calculate_concurrent()). If concurrency is
+selected, or if it is automatic and the network has fewer than CONCURRENT_DESTINATIONS destinations with nonzero demand
+per processor, then one evaluation context is created for each processor. Each context begins with a copy of the main
+assignment model and of the main context's flows.
+*/
+void Constraint::set_concurrency(int mode)
+{
+	int processors = GetProcessorCount(); // number of processors
+	bool small = (Assignment->Submodel->active_destinations.size() < CONCURRENT_DESTINATIONS * processors);
+	if ((mode == CONCURRENCY_OFF) || ((mode == CONCURRENCY_AUTO) && (small == false)))
+		return;
+
+	contexts.resize(processors);
+	for (int c = 0; c < processors; c++)
+	{
+		contexts[c].Assignment = Assignment->replicate();
+		contexts[c].Assignment->trace = false;
+		contexts[c].Assignment->Submodel->max_workers = 1;
+		contexts[c].sol_pair = context.sol_pair;
+	}
+}
+
 /**
 Converts user flow vector and waiting time scalar into a vector of the user cost components.
 
+Requires a flow vector/waiting time pair produced by the assignment model.
+
 Returns a vector of the user cost components, in the order of the solution log columns.
 */
-vector<double> Constraint::user_cost_components()
+vector<double> Constraint::user_cost_components(const pair<vector<double>, double> &assigned)
 {
 	vector<double> uc(UC_COMPONENTS, 0.0);
-	uc[2] = sol_pair.second;
+	uc[2] = assigned.second;
 
 	// In-vehicle riding time
 	for (int i = 0; i < Net->line_arcs.size(); i++)
-		uc[0] += sol_pair.first[Net->line_arcs[i]->id] * Net->line_arcs[i]->cost;
+		uc[0] += assigned.first[Net->line_arcs[i]->id] * Net->line_arcs[i]->cost;
 
 	// Walking time
 	for (int i = 0; i < Net->walking_arcs.size(); i++)
-		uc[1] += sol_pair.first[Net->walking_arcs[i]->id] * Net->walking_arcs[i]->cost;
+		uc[1] += assigned.first[Net->walking_arcs[i]->id] * Net->walking_arcs[i]->cost;
 
 	return uc;
 }
+
+/**
+Chooses the stratified sample of destinations used to screen solutions.
+
+The destinations with nonzero incoming demand are sorted in descending order of their total incoming demand and divided
+into SAMPLE_STRATA strata of (nearly) equal size. The total sample size is the sample fraction of all such destinations,
+and it is divided between the strata in proportion to their total demand, since the destinations with the most demand
+contribute the most to the user cost. Every stratum receives at least SAMPLE_MIN destinations (or all of them, if it is
+smaller), which is needed to estimate its variance.
+
+Within each stratum the destinations are chosen systematically at evenly spaced positions of the demand order, so that
+the same sample is used for every solution and the screening results of different solutions are directly comparable.
+Each sampled destination's weight is the size of its stratum divided by the number of destinations sampled from it.
+*/
+void Constraint::build_sample()
+{
+	ConstantAssignment * Submodel = Assignment->Submodel; // constant-cost submodel that solves the sample
+
+	// Sort active destinations in descending order of total incoming demand
+	vector<int> dests = Submodel->active_destinations;
+	vector<double> demand(stop_size, 0.0); // total incoming demand of each destination
+	for (int i = 0; i < dests.size(); i++)
+		for (int j = 0; j < Net->stop_nodes[dests[i]]->incoming_demand.size(); j++)
+			demand[dests[i]] += Net->stop_nodes[dests[i]]->incoming_demand[j];
+	stable_sort(dests.begin(), dests.end(), [&](int a, int b)
+	{
+		return demand[a] > demand[b];
+	});
+
+	// Divide destinations into strata and find each stratum's total demand
+	int count = dests.size(); // number of destinations
+	int stratum_count = min(SAMPLE_STRATA, count); // number of nonempty strata
+	vector<vector<int>> members(stratum_count); // destinations of each stratum
+	vector<double> stratum_demand(stratum_count, 0.0); // total demand of each stratum
+	double total_demand = 0.0; // total demand over all destinations
+	for (int i = 0; i < count; i++)
+	{
+		int h = (int) (((long long) i * stratum_count) / count); // stratum of ith destination
+		members[h].push_back(dests[i]);
+		stratum_demand[h] += demand[dests[i]];
+		total_demand += demand[dests[i]];
+	}
+
+	// Choose a demand-weighted number of destinations from each stratum at evenly spaced positions
+	int sample_size = (int) ceil(sample_fraction * count); // total target sample size
+	Submodel->sample_weight.assign(stop_size, 0.0);
+	strata.assign(stratum_count, vector<int>());
+	strata_size.assign(stratum_count, 0);
+	for (int h = 0; h < stratum_count; h++)
+	{
+		int size = members[h].size(); // stratum size
+		int n = (int) round(sample_size * stratum_demand[h] / total_demand); // stratum sample size
+		n = min(max(n, min(SAMPLE_MIN, size)), size);
+		for (int k = 0; k < n; k++)
+		{
+			int s = members[h][(int) ((k + 0.5) * size / n)]; // chosen destination
+			strata[h].push_back(s);
+			Submodel->sample_weight[s] = (1.0 * size) / n;
+		}
+		strata_size[h] = size;
+	}
+
+	// Measure each destination's contribution to the user cost
+	Submodel->value_arc_weight.assign(Net->core_arcs.size(), 0.0);
+	for (int i = 0; i < Net->line_arcs.size(); i++)
+		Submodel->value_arc_weight[Net->line_arcs[i]->id] = riding_weight * Net->line_arcs[i]->cost;
+	for (int i = 0; i < Net->walking_arcs.size(); i++)
+		Submodel->value_arc_weight[Net->walking_arcs[i]->id] = walking_weight * Net->walking_arcs[i]->cost;
+	Submodel->value_waiting_weight = waiting_weight;
+}
+
+/**
+Estimates the user cost components of a solution using only the sampled destinations.
+
+Requires a solution vector and the evaluation context to use.
+
+Returns a vector of the estimated user cost components, in the order of the solution log columns. Also sets the
+context's estimated total user cost and the half-width of its confidence interval.
+
+The nonlinear assignment model is run as usual, except that its constant-cost submodel solves only the sampled
+destinations and multiplies their results by their weights. The estimated total user cost is computed from the resulting
+flows. Its variance is estimated with the usual stratified sampling formula, using the contributions of the sampled
+destinations to the user cost in the final Frank-Wolfe subproblem, and the confidence interval extends the specified
+number of standard errors to either side. Strata that are fully sampled contribute no variance.
+
+The flows found here are only estimates, and so they do not replace the flows used to start the next full assignment.
+*/
+vector<double> Constraint::sample_user_cost(const vector<int> &sol, EvaluationContext &ctx)
+{
+	ConstantAssignment * Submodel = ctx.Assignment->Submodel; // constant-cost submodel that solves the sample
+
+	// Run assignment model over the sample
+	Submodel->sampling = true;
+	pair<vector<double>, double> sample_pair = ctx.Assignment->calculate(sol, warm_start(ctx));
+	Submodel->sampling = false;
+
+	// Calculate estimated user cost components and total
+	vector<double> ucc = user_cost_components(sample_pair);
+	ctx.uc_estimate = riding_weight*ucc[0] + walking_weight*ucc[1] + waiting_weight*ucc[2];
+
+	// Estimate variance from the spread of each stratum's destination contributions
+	double variance = 0.0;
+	for (int h = 0; h < strata.size(); h++)
+	{
+		int n = strata[h].size(); // stratum sample size
+		if ((n < 2) || (n == strata_size[h]))
+			continue;
+		double mean = 0.0; // mean sampled contribution
+		for (int k = 0; k < n; k++)
+			mean += Submodel->destination_value[strata[h][k]];
+		mean /= n;
+		double spread = 0.0; // sample variance of contributions
+		for (int k = 0; k < n; k++)
+			spread += pow(Submodel->destination_value[strata[h][k]] - mean, 2);
+		spread /= n - 1;
+		variance += pow(strata_size[h], 2) * (1 - (1.0 * n) / strata_size[h]) * spread / n;
+	}
+	ctx.uc_half_width = sample_z * sqrt(variance);
+
+	return ucc;
+}
+
+/**
+Finds a lower bound for the user cost of a solution with a single uncongested constant-cost assignment.
+
+Requires a solution vector and the evaluation context to use.
+
+Returns a vector of the user cost components of the free-flow solution, in the order of the solution log columns. Their
+weighted total is a lower bound for the user cost of the solution's equilibrium flows.
+
+The conical congestion function never falls below an arc's base cost, and the user cost is measured using base costs.
+The constant-cost submodel is therefore solved once with each arc's cost set to its user cost weight times its base cost
+(divided by the waiting time weight, so that the waiting time is also weighted correctly). Its optimal strategy
+minimizes the user cost over all feasible flows, including the equilibrium flows. This requires a positive waiting time
+weight, without which the prescreen is turned off when the constraint object is built.
+
+The context's submodel is used without warm starts, and its work measurements are restored afterwards, so that the
+free-flow solve leaves the replay orders and destination schedule of the context's equilibrium assignments unchanged.
+*/
+vector<double> Constraint::free_flow_user_cost(const vector<int> &sol, EvaluationContext &ctx)
+{
+	vector<double> arc_costs(Net->core_arcs.size()); // weighted base costs
+	for (int i = 0; i < arc_costs.size(); i++)
+		arc_costs[i] = Assignment->uc_arc_weight[i] / waiting_weight;
+
+	// Solve the constant-cost model without disturbing the state kept for the equilibrium assignments
+	ConstantAssignment * Submodel = ctx.Assignment->Submodel; // context's constant-cost submodel
+	bool warm = Submodel->warm_start; // whether the submodel was replaying warm starts
+	vector<int> work = Submodel->destination_work; // work measurements of the last equilibrium assignment
+	Submodel->warm_start = false;
+	pair<vector<double>, double> free_pair = Submodel->calculate(sol, arc_costs); // free-flow flows and waiting
+	Submodel->warm_start = warm;
+	Submodel->destination_work.swap(work);
+
+	return user_cost_components(free_pair);
+}
+
+/**
+Returns the flows that an evaluation context's assignment model should be warm-started from.
+
+These are the flows of the solution chosen by set_parent(), if it has a stored snapshot, and otherwise the flows of the
+context's most recent full assignment.
+*/
+const pair<vector<double>, double> & Constraint::warm_start(const EvaluationContext &ctx)
+{
+	if (parent_pair.first.size() > 0)
+		return parent_pair;
+	return ctx.sol_pair;
+}
+
+/**
+Stores the flows of a full assignment as the snapshot of a given solution.
+
+Requires the solution vector and the flow vector/waiting time pair that it produced.
+
+Snapshots are compressed by keeping only the nonzero arc flows, in single precision. A neighboring solution differs by a
+single line's fleet size, so this precision is far finer than the difference between the two solutions' equilibria.
+*/
+void Constraint::store_snapshot(const vector<int> &sol, const pair<vector<double>, double> &assigned)
+{
+	flow_snapshot &snap = snapshots[sol];
+	snap.first.clear();
+	for (int i = 0; i < assigned.first.size(); i++)
+		if (assigned.first[i] != 0)
+			snap.first.push_back(make_pair(i, (float) assigned.first[i]));
+	snap.second = assigned.second;
+}
+
+/**
+Sets the solution whose stored flows warm-start all future assignments.
+
+Requires a solution vector, which is normally the current solution of the search, since each candidate is one of its
+neighbors and so has a similar equilibrium.
+
+If the solution has no stored snapshot then future assignments are warm-started from the most recent full assignment in
+their evaluation context.
+*/
+void Constraint::set_parent(const vector<int> &sol)
+{
+	parent_pair.first.clear();
+	if (snapshots.count(sol) == 0)
+		return;
+	const flow_snapshot &snap = snapshots[sol];
+	parent_pair.first.resize(Net->core_arcs.size(), 0.0);
+	for (int i = 0; i < snap.first.size(); i++)
+		parent_pair.first[snap.first[i].first] = snap.first[i].second;
+	parent_pair.second = snap.second;
+}
+
+/**
+Predicts the change in total user cost caused by changing each line's fleet size.
+
+Requires a solution vector and the change to apply to each line's fleet size.
+
+Returns a vector of the predicted change in total user cost for each line, and sets the sensitivity margin to the user
+cost bound minus the total user cost of the flows that the prediction is based on. These are the solution's own
+equilibrium flows, taken from its stored snapshot. The predicted user cost of changing line l is then the bound minus
+the sensitivity margin plus the l-th element. If the user cost constraint is disabled, or if the solution has no stored
+snapshot, then the margin is infinite and every prediction is zero. Flows from any other evaluation (such as the most
+recent one) are never used, since they belong to a different solution.
+
+The predictions are first-order, with every arc flow held fixed. A line's fleet size enters the model through the
+frequencies of its boarding arcs and the capacities of its line arcs:
+	Waiting time: At a stop whose departing attractive boarding arcs have total frequency F, the boarding arc a with
+		frequency f_a and flow v_a carries the share f_a/F of the flow V through the stop, which waits V/F = v_a/f_a in
+		total. Changing f_a by df then changes the waiting time by -(v_a/f_a)/F df.
+	Congestion: The conical cost of a line arc depends on its flow times its inverse capacity, so its derivative with
+		respect to the inverse capacity is its flow derivative times v/inv. Capacity is proportional to fleet size, so
+		changing the fleet size from n by dn changes the inverse capacity by about -inv dn/n.
+The user cost measures in-vehicle time at the base costs, so congestion changes it only by diverting passengers. The
+change in the congested cost of the current in-vehicle flows is used as a proxy for this, weighted like riding time.
+*/
+vector<double> Constraint::sensitivities(const vector<int> &sol, int change)
+{
+	vector<double> predicted(sol.size(), 0.0); // predicted user cost change of each line
+	sensitivity_margin = INFINITY;
+	if ((uc_percent_increase < 0) || (snapshots.count(sol) == 0))
+		return predicted;
+
+	// Expand the solution's stored flows
+	const flow_snapshot &snap = snapshots[sol];
+	pair<vector<double>, double> flows(vector<double>(Net->core_arcs.size(), 0.0), snap.second); // flows of solution
+	for (int i = 0; i < snap.first.size(); i++)
+		flows.first[snap.first[i].first] = snap.first[i].second;
+
+	// Find the current margin
+	vector<double> ucc = user_cost_components(flows);
+	sensitivity_margin = (1 + uc_percent_increase)*initial_user_cost -
+		(riding_weight*ucc[0] + walking_weight*ucc[1] + waiting_weight*ucc[2]);
+
+	// Find the total frequency of the boarding arcs in use leaving each node
+	vector<double> departing(Net->nodes.size(), 0.0); // total attractive departing frequency of each node
+	for (int l = 0; l < sol.size(); l++)
+		for (int i = 0; i < Net->lines[l]->boarding.size(); i++)
+			if (flows.first[Net->lines[l]->boarding[i]->id] > 0)
+				departing[Net->lines[l]->boarding[i]->tail->id] += Net->lines[l]->frequency(sol[l]);
+
+	// Add up each line's waiting time and congestion terms
+	for (int l = 0; l < sol.size(); l++)
+	{
+		// Lines that are not running carry no flow
+		if (sol[l] <= 0)
+			continue;
+		double freq = Net->lines[l]->frequency(sol[l]); // current frequency
+		double freq_change = Net->lines[l]->frequency(sol[l] + change) - freq; // change in frequency
+		double inv_capacity = 1.0 / Net->lines[l]->capacity(sol[l]); // current inverse capacity
+		double inv_change = -inv_capacity * change / sol[l]; // first-order change in inverse capacity
+
+		// Waiting time
+		for (int i = 0; i < Net->lines[l]->boarding.size(); i++)
+		{
+			Arc * board = Net->lines[l]->boarding[i];
+			double v = flows.first[board->id];
+			if (v > 0)
+				predicted[l] -= waiting_weight * (v / freq) / departing[board->tail->id] * freq_change;
+		}
+
+		// Congestion
+		for (int i = 0; i < Net->lines[l]->in_vehicle.size(); i++)
+		{
+			int id = Net->lines[l]->in_vehicle[i]->id;
+			double v = flows.first[id];
+			predicted[l] += riding_weight * v * (Assignment->arc_cost_derivative(id, v, inv_capacity) * v /
+				inv_capacity) * inv_change;
+		}
+	}
+
+	return predicted;
+}
+
+/**
+Deletes the stored snapshots of all solutions except for a given list.
+
+Requires a vector of the solution vectors whose snapshots should be kept.
+*/
+void Constraint::keep_snapshots(const vector<vector<int>> &keep)
+{
+	map<vector<int>, flow_snapshot> kept;
+	for (int i = 0; i < keep.size(); i++)
+	{
+		auto it = snapshots.find(keep[i]);
+		if (it != snapshots.end())
+			kept[keep[i]] = it->second;
+	}
+	snapshots.swap(kept);
+}
+
+/**
+Writes the stored snapshots to the snapshot file.
+
+After a comment line, each row contains a solution string, its waiting time, and then alternating arc IDs and flows for
+each of its nonzero arc flows, all tab-separated.
+*/
+void Constraint::save_snapshots()
+{
+	ofstream snap_file;
+	snap_file.open(FILE_BASE + SNAPSHOT_FILE);
+	if (snap_file.is_open())
+	{
+		snap_file << "Solution\tWaiting\tFlows" << endl;
+		for (auto it = snapshots.begin(); it != snapshots.end(); it++)
+		{
+			for (int i = 0; i < it->first.size(); i++)
+				snap_file << (i > 0 ? string(1, DELIMITER) : "") << it->first[i];
+			snap_file << '\t' << setprecision(15) << it->second.second << setprecision(9);
+			for (int i = 0; i < it->second.first.size(); i++)
+				snap_file << '\t' << it->second.first[i].first << '\t' << it->second.first[i].second;
+			snap_file << endl;
+		}
+		snap_file.close();
+	}
+	else
+		cout << "Snapshot file failed to open." << endl;
+}
+
+/// Reads the snapshot file written by save_snapshots(), if it exists, adding its snapshots to the stored snapshots.
+void Constraint::load_snapshots()
+{
+	ifstream snap_file;
+	snap_file.open(FILE_BASE + SNAPSHOT_FILE);
+	if (snap_file.is_open())
+	{
+		string line, piece; // whole line and line element being read
+		getline(snap_file, line); // skip comment line
+
+		while (snap_file.eof() == false)
+		{
+			// Get whole line as a string stream
+			getline(snap_file, line);
+			if (line.size() == 0)
+				// Break for blank line at file end
+				break;
+			stringstream stream(line);
+
+			// Read the solution string, then the waiting time and flows
+			vector<int> sol;
+			getline(stream, piece, '\t');
+			stringstream sol_stream(piece);
+			while (getline(sol_stream, piece, DELIMITER))
+				sol.push_back(stoi(piece));
+			flow_snapshot &snap = snapshots[sol];
+			snap.first.clear();
+			getline(stream, piece, '\t');
+			snap.second = stod(piece);
+			while (getline(stream, piece, '\t'))
+			{
+				int id = stoi(piece);
+				getline(stream, piece, '\t');
+				snap.first.push_back(make_pair(id, stof(piece)));
+			}
+		}
+
+		snap_file.close();
+	}
+}
@@ -7,8 +7,12 @@ calling the assignment model.
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -21,6 +25,26 @@ using namespace std;
 
 extern string FILE_BASE;
 
+// Type definitions
+typedef pair<vector<pair<int, float>>, double> flow_snapshot; // nonzero arc flows (single precision)/waiting time
+
+/**
+Per-call state of constraint evaluations.
+
+Everything that a single evaluation changes is kept here, so that evaluations in different contexts can run at the same
+time while sharing the read-only network and the constraint object's settings. Each context's assignment model has its
+own constant-cost submodel, whose label setting warm starts persist between the evaluations made in that context.
+*/
+struct EvaluationContext
+{
+	// Public attributes
+	NonlinearAssignment * Assignment; // pointer to the assignment model object used by this context
+	pair<vector<double>, double> sol_pair; // flow vector/waiting time pair of the most recent full assignment
+	double uc_estimate = 0.0; // sampled estimate of the total user cost from the most recent screening
+	double uc_half_width = 0.0; // half-width of the confidence interval of the most recent sampled estimate
+	int source = CON_SOURCE_FULL; // source of the most recently calculated constraint function elements
+};
+
 /**
 Constraint function class.
 
@@ -36,17 +60,53 @@ struct Constraint
 	// Public attributes
 	Network * Net; // pointer to the main transit network object
 	NonlinearAssignment * Assignment; // pointer to the assignment model object
-	pair<vector<double>, double> sol_pair; // flow vector/waiting time pair produced by assignment model
+	EvaluationContext context; // per-call state of ordinary evaluations (using the main assignment model)
+	vector<EvaluationContext> contexts; // contexts for concurrent evaluations (empty if not used)
 	double initial_user_cost; // initial user cost for use in determining the user cost upper bound
 	double uc_percent_increase; // allowed percent increase in user cost function
 	double riding_weight; // user cost weight for in-vehicle travel time
 	double walking_weight; // user cost weight for walking time
 	double waiting_weight; // user cost weight for waiting time
 	int stop_size; // number of stop nodes (also number of O/D nodes)
+	double sample_fraction = 0.0; // fraction of destinations sampled to screen solutions (0 to skip screening)
+	double sample_z = 1.96; // number of standard errors on each side of the sampled user cost estimate
+	double gap_margin = 0.0; // multiple of the assignment error bound used to decide feasibility early (0 to skip)
+	bool free_flow = false; // whether to prescreen solutions using the free-flow user cost lower bound
+	vector<vector<int>> strata; // sampled destinations of each demand stratum
+	vector<int> strata_size; // total number of destinations in each demand stratum
+	int source = CON_SOURCE_FULL; // source of the most recently calculated constraint function elements
+	vector<int> sources; // source of each result of the most recent batch evaluation
+	int fidelity = FIDELITY_TIGHT; // tolerance profile of the most recently calculated constraint function elements
+	bool snapshots_on = false; // whether to store the equilibrium flows of evaluated solutions for warm starts
+	map<vector<int>, flow_snapshot> snapshots; // compressed equilibrium flows of stored solutions
+	CancelToken * Cancel = NULL; // pointer to the cancellation token (NULL if evaluations cannot be cancelled)
+	pair<vector<double>, double> parent_pair; // flows of the solution to warm-start from (empty if none is stored)
+	double sensitivity_margin = INFINITY; // user cost bound minus the user cost of the flows used by sensitivities()
 
 	// Public methods
 	Constraint(Network *); // constructor reads op cost, user cost, init flow, assignment data, sets net obj pointer
 	~Constraint(); // destructor deletes the assignment model object
 	pair<int, vector<double>> calculate(const vector<int> &); // evaluates constraint functions for a given solution
-	vector<double> user_cost_components(); // uses flow vector and waiting time scalar to calculate user cost components
+	vector<pair<int, vector<double>>> calculate_batch(const vector<vector<int>> &); // evaluates several solutions
+	vector<pair<int, vector<double>>> calculate_concurrent(const vector<vector<int>> &); // evaluates sols concurrently
+	pair<int, vector<double>> screen(const vector<int> &, EvaluationContext &, double); // prescreens a single solution
+	pair<int, vector<double>> evaluate(const vector<int> &, EvaluationContext &, double); // evaluates sol in a context
+	pair<int, vector<double>> verify(const vector<int> &); // evaluates a solution in full at tight tolerances
+	pair<int, vector<double>> full_result(const pair<vector<double>, double> &, int,
+		double); // feasibility and user cost components of a full assignment
+	void set_concurrency(int); // creates the contexts for concurrent evaluations if they are selected
+	void calibrate(const vector<int> &); // sets the initial user cost to that of a reference solution on this network
+	void set_fidelity(int); // sets the assignment model's tolerance profile for future evaluations
+	void set_cancel(CancelToken *); // sets the cancellation token of this object and its assignment models
+	vector<double> user_cost_components(const pair<vector<double>, double> &); // user cost components of flows/waiting
+	void build_sample(); // chooses the stratified destination sample and its weights
+	vector<double> sample_user_cost(const vector<int> &, EvaluationContext &); // estimates uc components from sample
+	vector<double> free_flow_user_cost(const vector<int> &, EvaluationContext &); // uc components of free-flow bound
+	const pair<vector<double>, double> & warm_start(const EvaluationContext &); // flows to warm-start a context from
+	void store_snapshot(const vector<int> &, const pair<vector<double>, double> &); // stores the flows of a solution
+	void set_parent(const vector<int> &); // warm-starts future evaluations from a stored solution's flows (if any)
+	vector<double> sensitivities(const vector<int> &, int); // predicted user cost change of changing each line's fleet
+	void keep_snapshots(const vector<vector<int>> &); // deletes the stored flows of all but the listed solutions
+	void save_snapshots(); // writes the stored flows to the snapshot file
+	void load_snapshots(); // reads the stored flows from the snapshot file (if present)
 };
@@ -22,6 +22,10 @@
 #define EVENT_LOG_FILE "log/event.txt"
 #define MEMORY_LOG_FILE "log/memory.txt"
 #define FINAL_SOLUTION_FILE "log/final.txt"
+#define COARSE_REPORT_FILE "log/coarse.txt"
+#define SURROGATE_REPORT_FILE "log/surrogate.txt"
+#define SNAPSHOT_FILE "log/snapshots.txt"
+#define TRACE_FILE "log/assignment_trace.txt"
 
 // Exit codes
 #define SUCCESSFUL_EXIT 0
@@ -42,12 +46,50 @@
 #define ACCESS_ARC 4
 #define NO_ID -1
 
+// Priority queue types
+#define QUEUE_BINARY 0
+#define QUEUE_RADIX 1
+
 // Feasibility codes
 #define FEAS_TRUE 1
 #define FEAS_FALSE 0
 #define FEAS_UNKNOWN -1
 #define FEAS_BAN 2
 
+// Frank-Wolfe step size methods
+#define FW_MSA 0
+#define FW_LINE_SEARCH 1
+#define FW_CONJUGATE 2
+#define FW_BICONJUGATE 3
+
+// Equilibrium solvers
+#define ENGINE_FRANK_WOLFE 0
+#define ENGINE_SIMPLICIAL 1
+#define ENGINE_DESTINATION 2
+
+// Constraint sources
+#define CON_SOURCE_FULL 0
+#define CON_SOURCE_SAMPLE 1
+#define CON_SOURCE_BOUND 2
+#define CON_SOURCE_FREE_FLOW 3
+#define CON_SOURCE_ABANDONED 4
+
+// Concurrent constraint evaluation modes
+#define CONCURRENCY_OFF 0
+#define CONCURRENCY_AUTO 1
+#define CONCURRENCY_ON 2
+
+// Assignment tolerance profiles
+#define FIDELITY_TIGHT 0
+#define FIDELITY_LOOSE 1
+
+// Assignment stopping rules
+#define STOP_CUTOFF 1
+#define STOP_ERROR 2
+#define STOP_CHANGE 3
+#define STOP_BOUND 4
+#define STOP_CANCEL 5
+
 // Pickup codes
 #define CONTINUE_SEARCH 1
 #define NEW_SEARCH 0
@@ -58,6 +100,8 @@
 #define SOL_LOG_CON_TIME 2
 #define SOL_LOG_OBJ 3
 #define SOL_LOG_OBJ_TIME 4
+#define SOL_LOG_CON_SOURCE 5
+#define SOL_LOG_CON_FIDELITY 6
 
 // Event log codes
 #define EVENT_IMPROVEMENT 1
@@ -75,3 +119,18 @@
 // Other technical definitions
 #define EPSILON 0.00000001 // very small positive value
 #define LARGE 10e20 // very large positive value
+#define REDUCTION_BLOCK 1024 // number of arcs summed together by each task of a deterministic reduction
+#define WARM_PASSES 3 // maximum number of replays attempted by a label setting warm start
+#define WARM_BATCH 4 // number of destinations replayed together by a batched warm start
+#define SAMPLE_STRATA 4 // number of demand strata used by the sampled user cost estimator
+#define SAMPLE_MIN 2 // minimum number of destinations sampled from each stratum
+#define LINE_SEARCH_TOL 0.000001 // step size interval width at which the Frank-Wolfe line search stops
+#define CONCURRENT_DESTINATIONS 64 // destinations per processor below which candidates are evaluated concurrently
+#define LINE_SEARCH_MAX 30 // maximum number of derivative evaluations in the Frank-Wolfe line search
+#define CONJUGATE_MAX 0.99999 // largest weight of the previous target in a conjugate Frank-Wolfe direction
+#define SIMPLICIAL_POOL 20 // maximum number of columns kept by simplicial decomposition
+#define SIMPLICIAL_MASTER 50 // maximum number of iterations per simplicial decomposition master problem
+#define SIMPLICIAL_MASTER_GAP 0.1 // simplicial decomposition master problem tolerance as a fraction of the error bound
+#define DESTINATION_POOL 8 // maximum number of strategies kept for each destination by the destination-based solver
+#define DESTINATION_SWEEPS 2 // passes over the destinations per constant-cost solve by the destination-based solver
+#define DESTINATION_STEPS 3 // maximum number of flow shifts per destination per pass by the destination-based solver
@@ -59,19 +59,21 @@ Signal handler for safe stop request.
 
 Executes whenever the user presses [Ctrl]+[C] on the keyboard (or with the "raise(SIGINT)" command).
 
-Sets the global solver's stop request variable to true, which causes the main search loop to end after it completes its
-current iteration.
+Sets the global solver's stop request variable to true and requests that its evaluators stop. The search then ends
+as soon as its current evaluation stops, discarding the unfinished iteration (see Search::stop_check()). If no
+evaluation is running then the main search loop instead ends after it completes its current iteration.
 */
 void STOP_REQUEST(int signum)
 {
 	cout << "\n\n****************************************" << endl;
 	cout << "************ STOP REQUESTED ************" << endl;
 	cout << "****************************************\n" << endl;
-	cout << "Program will safely exit at end of current loop (which may take a while)." << endl;
+	cout << "Program will safely exit once the current evaluation stops." << endl;
 	cout << "Do not close or data may be corrupted!" << endl;
 	cout << "\n****************************************" << endl;
 	cout << "************ STOP REQUESTED ************" << endl;
 	cout << "****************************************\n" << endl;
 
 	Solver->keyboard_halt = true;
+	Solver->cancel.request_stop();
 }
@@ -0,0 +1,156 @@
+/**
+Monotone priority queues used by the label setting and Dijkstra algorithms.
+
+Both the Spiess and Florian label setting algorithm and Dijkstra's algorithm only ever insert keys that are no smaller
+than the most recently removed key. This allows a radix heap to be used in place of a binary heap, replacing its
+O(log n) insertions with O(1) insertions and amortizing the cost of removals over the number of distinct key bits.
+
+A wrapper class allows either the radix heap or the standard binary heap to be selected at runtime for benchmarking.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "definitions.hpp"
+
+using namespace std;
+
+/**
+Radix heap for key/value pairs with nonnegative double keys.
+
+Keys are compared using their IEEE 754 bit patterns, which for nonnegative doubles (including infinity) are ordered in
+exactly the same way as the values themselves. No scaling or rounding is needed, and so the order of removal is exactly
+the same as for a binary heap except possibly among entries with equal keys.
+
+Entries are stored in buckets according to the highest bit in which their key differs from the last removed key. Bucket
+0 holds entries whose keys equal the last removed key. When it runs out, the lowest nonempty bucket is emptied into the
+lower buckets relative to its smallest key, which becomes the new last removed key.
+
+The heap requires every inserted key to be at least as large as the last removed key. Keys that fall below it, which can
+happen only due to floating point rounding in the label setting algorithm, are treated as equal to it.
+*/
+template <typename T>
+struct RadixHeap
+{
+	// Public attributes
+	vector<pair<double, T>> buckets[65]; // entries grouped by highest bit differing from the last removed key
+	uint64_t last = 0; // bit pattern of the last removed key
+	size_t count = 0; // number of entries in the heap
+
+	// Public methods
+	void push(const pair<double, T> &entry) // inserts a new entry
+	{
+		uint64_t key = key_bits(entry.first);
+		if (key < last)
+			key = last;
+		buckets[bit_length(key ^ last)].push_back(entry);
+		count++;
+	}
+	const pair<double, T> & top() // returns a minimum-key entry
+	{
+		refill();
+		return buckets[0].back();
+	}
+	void pop() // removes a minimum-key entry
+	{
+		refill();
+		buckets[0].pop_back();
+		count--;
+	}
+	bool empty() const // returns whether the heap is empty
+	{
+		return count == 0;
+	}
+	size_t size() const // returns the number of entries
+	{
+		return count;
+	}
+	void refill() // ensures that bucket 0 is nonempty by redistributing the lowest nonempty bucket
+	{
+		if (buckets[0].empty() == false)
+			return;
+
+		// Find lowest nonempty bucket and its smallest key
+		int b = 1;
+		while (buckets[b].empty() == true)
+			b++;
+		uint64_t smallest = key_bits(buckets[b][0].first);
+		for (int i = 1; i < buckets[b].size(); i++)
+			smallest = min(smallest, key_bits(buckets[b][i].first));
+
+		// Redistribute relative to the new last removed key
+		last = smallest;
+		for (int i = 0; i < buckets[b].size(); i++)
+			buckets[bit_length(key_bits(buckets[b][i].first) ^ last)].push_back(buckets[b][i]);
+		buckets[b].clear();
+	}
+	static uint64_t key_bits(double key) // returns the bit pattern of a key
+	{
+		uint64_t bits;
+		memcpy(&bits, &key, sizeof(bits));
+		return bits;
+	}
+	static int bit_length(uint64_t x) // returns the position of the highest set bit (0 if none)
+	{
+		int n = 0;
+		if (x >> 32) { x >>= 32; n += 32; }
+		if (x >> 16) { x >>= 16; n += 16; }
+		if (x >> 8) { x >>= 8; n += 8; }
+		if (x >> 4) { x >>= 4; n += 4; }
+		if (x >> 2) { x >>= 2; n += 2; }
+		if (x >> 1) { x >>= 1; n += 1; }
+		return n + (int) x;
+	}
+};
+
+/**
+Min-priority queue of key/value pairs that can be switched between a binary heap and a radix heap.
+
+Requires a queue type code (QUEUE_BINARY or QUEUE_RADIX) on construction. Its interface matches the subset of the
+standard priority queue interface used by the label setting and Dijkstra algorithms.
+*/
+template <typename T>
+struct MonotoneQueue
+{
+	// Public attributes
+	bool radix; // whether to use the radix heap rather than the binary heap
+	priority_queue<pair<double, T>, vector<pair<double, T>>, greater<pair<double, T>>> binary_heap; // binary heap
+	RadixHeap<T> radix_heap; // radix heap
+
+	// Public methods
+	MonotoneQueue(int type) // constructor sets the queue type
+	{
+		radix = (type == QUEUE_RADIX);
+	}
+	void push(const pair<double, T> &entry) // inserts a new entry
+	{
+		if (radix == true)
+			radix_heap.push(entry);
+		else
+			binary_heap.push(entry);
+	}
+	const pair<double, T> & top() // returns a minimum-key entry
+	{
+		if (radix == true)
+			return radix_heap.top();
+		return binary_heap.top();
+	}
+	void pop() // removes a minimum-key entry
+	{
+		if (radix == true)
+			radix_heap.pop();
+		else
+			binary_heap.pop();
+	}
+	bool empty() const // returns whether the queue is empty
+	{
+		if (radix == true)
+			return radix_heap.empty();
+		return binary_heap.empty();
+	}
+};
@@ -297,6 +297,190 @@ Network::Network()
 	}
 }
 
+/**
+Network constructor to build a coarsened copy of an existing network.
+
+Requires a pointer to the network to be coarsened and a walking time radius.
+
+Stop nodes joined by a chain of core walking arcs whose times are no greater than the radius are aggregated into a
+single stop node. Walking arcs within an aggregated stop are removed, and parallel walking arcs between the same pair of
+nodes are merged into a single arc with the smallest of their times. The travel demand is collapsed onto the aggregated
+stops, dropping any trips whose origin and destination were aggregated into the same stop.
+
+The lines, vehicle types, boarding nodes, population/facility nodes, and line/boarding/alighting arcs are all copied, so
+the coarse network accepts the same solution vectors as the original and can be handed to the same objective and
+constraint objects. The nodes and arcs are renumbered so that IDs still match list positions, with the stop nodes first.
+*/
+Network::Network(Network * fine, double radius)
+{
+	int fine_stops = fine->stop_nodes.size(); // number of original stop nodes
+
+	// Aggregate stops connected by short walking arcs (union-find, with each set rooted at its smallest stop ID)
+	vector<int> parent(fine_stops); // parent of each stop in the union-find forest
+	for (int i = 0; i < fine_stops; i++)
+		parent[i] = i;
+	auto root = [&](int i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+	for (int i = 0; i < fine->walking_arcs.size(); i++)
+	{
+		if (fine->walking_arcs[i]->cost > radius)
+			continue;
+		int u = root(fine->walking_arcs[i]->tail->id);
+		int v = root(fine->walking_arcs[i]->head->id);
+		parent[max(u, v)] = min(u, v);
+	}
+
+	// Copy vehicle types and lines (their arc lists are refilled below)
+	for (int i = 0; i < fine->vehicles.size(); i++)
+		vehicles.push_back(new Vehicle(*fine->vehicles[i]));
+	for (int i = 0; i < fine->lines.size(); i++)
+	{
+		Line * new_line = new Line(*fine->lines[i]);
+		new_line->boarding.clear();
+		new_line->in_vehicle.clear();
+		lines.push_back(new_line);
+	}
+
+	// Create one stop node for each aggregated stop
+	node_map.resize(fine->nodes.size(), NO_ID);
+	for (int i = 0; i < fine_stops; i++)
+	{
+		if (root(i) == i)
+		{
+			Node * new_node = new Node(nodes.size(), fine->stop_nodes[i]->value);
+			node_map[fine->stop_nodes[i]->id] = new_node->id;
+			nodes.push_back(new_node);
+			stop_nodes.push_back(new_node);
+			core_nodes.push_back(new_node);
+		}
+		else
+			node_map[fine->stop_nodes[i]->id] = node_map[fine->stop_nodes[root(i)]->id];
+	}
+
+	// Copy the remaining nodes
+	for (int i = 0; i < fine->boarding_nodes.size(); i++)
+	{
+		Node * new_node = new Node(nodes.size(), fine->boarding_nodes[i]->value);
+		node_map[fine->boarding_nodes[i]->id] = new_node->id;
+		nodes.push_back(new_node);
+		boarding_nodes.push_back(new_node);
+		core_nodes.push_back(new_node);
+	}
+	for (int i = 0; i < fine->population_nodes.size(); i++)
+	{
+		Node * new_node = new Node(nodes.size(), fine->population_nodes[i]->value);
+		node_map[fine->population_nodes[i]->id] = new_node->id;
+		nodes.push_back(new_node);
+		population_nodes.push_back(new_node);
+	}
+	for (int i = 0; i < fine->facility_nodes.size(); i++)
+	{
+		Node * new_node = new Node(nodes.size(), fine->facility_nodes[i]->value);
+		node_map[fine->facility_nodes[i]->id] = new_node->id;
+		nodes.push_back(new_node);
+		facility_nodes.push_back(new_node);
+	}
+
+	// Recover the type of each original arc from the lists it belongs to
+	arc_map.resize(fine->core_arcs.size() + fine->access_arcs.size(), NO_ID);
+	vector<int> arc_type(arc_map.size(), ALIGHTING_ARC); // type of each original arc
+	for (int i = 0; i < fine->core_arcs.size(); i++)
+		if (fine->core_arcs[i]->boarding == true)
+			arc_type[fine->core_arcs[i]->id] = BOARDING_ARC;
+	for (int i = 0; i < fine->line_arcs.size(); i++)
+		arc_type[fine->line_arcs[i]->id] = LINE_ARC;
+	for (int i = 0; i < fine->walking_arcs.size(); i++)
+		arc_type[fine->walking_arcs[i]->id] = WALKING_ARC;
+	for (int i = 0; i < fine->access_arcs.size(); i++)
+		arc_type[fine->access_arcs[i]->id] = ACCESS_ARC;
+
+	// Copy core arcs, removing walking arcs within an aggregated stop and merging parallel walking arcs
+	unordered_map<long long, Arc *> parallel; // merged walking arc for each tail/head pair
+	for (int i = 0; i < fine->core_arcs.size(); i++)
+	{
+		Arc * fine_arc = fine->core_arcs[i];
+		int type = arc_type[fine_arc->id];
+		int tail = node_map[fine_arc->tail->id];
+		int head = node_map[fine_arc->head->id];
+		if (type == WALKING_ARC)
+		{
+			if (tail == head)
+				continue;
+			long long key = (1LL * tail * fine->nodes.size()) + head;
+			if (parallel.count(key) > 0)
+			{
+				parallel[key]->cost = min(parallel[key]->cost, fine_arc->cost);
+				arc_map[fine_arc->id] = parallel[key]->id;
+				continue;
+			}
+		}
+
+		// The original cost already includes the small boarding/alighting cost, so it is copied as-is
+		Arc * new_arc = new Arc(core_arcs.size(), nodes[tail], nodes[head], fine_arc->cost, fine_arc->line, type);
+		arc_map[fine_arc->id] = new_arc->id;
+		core_arcs.push_back(new_arc);
+		nodes[tail]->core_out.push_back(new_arc);
+		nodes[head]->core_in.push_back(new_arc);
+		if (type == LINE_ARC)
+		{
+			line_arcs.push_back(new_arc);
+			lines[new_arc->line]->in_vehicle.push_back(new_arc);
+		}
+		if (type == BOARDING_ARC)
+			lines[new_arc->line]->boarding.push_back(new_arc);
+		if (type == WALKING_ARC)
+		{
+			walking_arcs.push_back(new_arc);
+			parallel[(1LL * tail * fine->nodes.size()) + head] = new_arc;
+		}
+	}
+
+	// Copy access arcs in the same way, numbering them after the core arcs
+	parallel.clear();
+	for (int i = 0; i < fine->access_arcs.size(); i++)
+	{
+		Arc * fine_arc = fine->access_arcs[i];
+		int tail = node_map[fine_arc->tail->id];
+		int head = node_map[fine_arc->head->id];
+		if (tail == head)
+			continue;
+		long long key = (1LL * tail * fine->nodes.size()) + head;
+		if (parallel.count(key) > 0)
+		{
+			parallel[key]->cost = min(parallel[key]->cost, fine_arc->cost);
+			arc_map[fine_arc->id] = parallel[key]->id;
+			continue;
+		}
+		Arc * new_arc = new Arc(core_arcs.size() + access_arcs.size(), nodes[tail], nodes[head], fine_arc->cost,
+			fine_arc->line, ACCESS_ARC);
+		arc_map[fine_arc->id] = new_arc->id;
+		access_arcs.push_back(new_arc);
+		nodes[tail]->access_out.push_back(new_arc);
+		parallel[key] = new_arc;
+	}
+
+	// Collapse travel demands onto the aggregated stops
+	for (int i = 0; i < stop_nodes.size(); i++)
+		stop_nodes[i]->incoming_demand.resize(stop_nodes.size(), 0.0);
+	for (int i = 0; i < fine_stops; i++)
+	{
+		int destination = node_map[fine->stop_nodes[i]->id];
+		for (int j = 0; j < fine_stops; j++)
+		{
+			int origin = node_map[fine->stop_nodes[j]->id];
+			if (origin != destination)
+				stop_nodes[destination]->incoming_demand[origin] += fine->stop_nodes[i]->incoming_demand[j];
+		}
+	}
+}
+
 /// Network destructor deletes all Node, Arc, and Line objects created by the constructor.
 Network::~Network()
 {
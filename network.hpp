@@ -7,6 +7,7 @@ which they are mostly treated as read-only for use in the objective and constrai
 
 #pragma once
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -37,6 +38,9 @@ Most of the network objects are partitioned into a "core" set which is used for
 nodes and line/boarding/alighting/walking arcs), and an "access" set which is only needed for the primary care access
 metrics (including population/facility nodes and their associated walking arcs). Only the core set needs to be
 considered for the constraint calculation, while the access sets must be added in for the objective.
+
+A coarsened copy of a network can also be built from an existing network, in which case the node and arc maps record
+where each of the original network's elements ended up.
 */
 struct Network
 {
@@ -53,9 +57,12 @@ struct Network
 	vector<Arc *> line_arcs; // pointers to all core network line arcs
 	vector<Arc *> walking_arcs; // pointers to all core network walking arcs
 	vector<Arc *> access_arcs; // pointers to access network walking arcs
+	vector<int> node_map; // (coarse networks only) coarse node ID of each node of the original network
+	vector<int> arc_map; // (coarse networks only) coarse arc ID of each arc of the original network (-1 if removed)
 
 	// Public methods
 	Network(); // constructor uses input data file names from the definition header to automatically build the network
+	Network(Network *, double); // constructor builds a coarsened copy of a network by aggregating nearby stops
 	~Network(); // destructor deletes all Node, Arc, and Line objects
 };
 
@@ -43,6 +43,8 @@ Objective::Objective(Network * net_in)
 				gravity_exponent = stod(value);
 			if (count == 4)
 				multiplier = stod(value);
+			if (count == 5)
+				queue_type = stoi(value);
 		}
 
 		obj_file.close();
@@ -61,10 +63,67 @@ Requires a solution vector, which is passed directly to the all_metrics() method
 center gravity metrics. The objective value is the sum of the lowest few of these metrics (specifically, the number
 stored in "lowest_metrics"). Because the TS/SA algorithm is written to minimize its objective, we actually return the
 negative of this value.
+
+If a stop is requested during the calculation then the remaining population centers are skipped, and the returned value
+is meaningless. The caller must check for the stop request and discard it.
 */
 double Objective::calculate(const vector<int> &fleet)
 {
-	vector<double> metrics = all_metrics(fleet); // calculate all metrics
+	return objective_value(all_metrics(fleet));
+}
+
+/**
+Calculates the objective values of several solutions at once.
+
+Requires a vector of solution vectors.
+
+Returns a vector of objective values, in the same order as the solutions.
+
+A single objective calculation is parallelized over its population centers, so on a network with few population
+centers most processors sit idle while its slowest Dijkstra searches finish. Here the searches of all of the solutions
+are instead pooled into a single parallel loop over solution/population center pairs. Each solution's metrics are then
+calculated from its own distances exactly as in calculate(), so the results are identical to calculating the solutions
+one at a time. As in calculate(), the returned values are meaningless if a stop is requested.
+*/
+vector<double> Objective::calculate_batch(const vector<vector<int>> &fleets)
+{
+	int count = fleets.size(); // number of solutions
+
+	// Generate each solution's core arc costs and distance matrix
+	vector<vector<double>> arc_costs(count); // core arc total costs of each solution
+	vector<vector<vector<double>>> distances(count); // population center-to-facility distances of each solution
+	for (int f = 0; f < count; f++)
+	{
+		arc_costs[f] = core_costs(fleets[f]);
+		distances[f].resize(pop_size, vector<double>(fac_size));
+	}
+
+	// Calculate all distance rows in parallel over all solutions and sources
+	parallel_for(0, count*pop_size, [&](int k)
+	{
+		int f = k / pop_size; // solution of this task
+		int i = k % pop_size; // population center of this task
+		if ((Cancel == NULL) || (Cancel->stop_requested() == false))
+			population_to_all_facilities(i, arc_costs[f], distances[f][i]);
+	});
+
+	// Calculate each solution's objective value from its distances
+	vector<double> objectives(count);
+	for (int f = 0; f < count; f++)
+		objectives[f] = objective_value(gravity_metrics(distances[f]));
+
+	return objectives;
+}
+
+/**
+Calculates the objective value for a given set of population center gravity metrics.
+
+Requires a vector of gravity metrics, which is sorted in place.
+
+Returns the negative sum of the lowest metrics (see calculate()).
+*/
+double Objective::objective_value(vector<double> metrics)
+{
 	sort(metrics.begin(), metrics.end()); // sort metrics in ascending order
 
 	double sum = 0; // sum lowest metrics
@@ -82,6 +141,32 @@ Requires a solution vector, which is then used to calculate the gravity metrics
 Returns a vector of gravity metrics for each population center, ordered in the same way as the population center list.
 */
 vector<double> Objective::all_metrics(const vector<int> &fleet)
+{
+	vector<double> arc_costs = core_costs(fleet); // core arc total costs
+
+	// Initialize a population center-to-facility distance matrix
+	vector<vector<double>> distance(pop_size);
+	for (int i = 0; i < pop_size; i++)
+		distance[i].resize(fac_size);
+
+	// Calculate distances row-by-row using single-source Dijkstra in parallel over all sources
+	parallel_for(0, pop_size, [&](int i)
+	{
+		if ((Cancel == NULL) || (Cancel->stop_requested() == false))
+			population_to_all_facilities(i, arc_costs, distance[i]);
+	});
+
+	return gravity_metrics(distance);
+}
+
+/**
+Calculates the total cost of each core arc for a given solution.
+
+Requires a solution vector.
+
+Returns a vector of core arc costs, each consisting of the arc's base cost plus the headway of its line (if any).
+*/
+vector<double> Objective::core_costs(const vector<int> &fleet)
 {
 	// Generate a vector of line headways based on the fleet sizes
 	vector<double> headways(Net->lines.size());
@@ -97,17 +182,18 @@ vector<double> Objective::all_metrics(const vector<int> &fleet)
 			arc_costs[i] += headways[Net->core_arcs[i]->line]; // headway
 	}
 
-	// Initialize a population center-to-facility distance matrix
-	vector<vector<double>> distance(pop_size);
-	for (int i = 0; i < pop_size; i++)
-		distance[i].resize(fac_size);
+	return arc_costs;
+}
 
-	// Calculate distances row-by-row using single-source Dijkstra in parallel over all sources
-	parallel_for(0, pop_size, [&](int i)
-	{
-		population_to_all_facilities(i, arc_costs, distance[i]);
-	});
+/**
+Calculates the gravity metrics of all population centers from their distances to the facilities.
+
+Requires a reference to the population center-to-facility distance matrix.
 
+Returns a vector of gravity metrics for each population center, ordered in the same way as the population center list.
+*/
+vector<double> Objective::gravity_metrics(vector<vector<double>> &distance)
+{
 	// Calculate facility metrics
 	vector<double> fac_met(fac_size);
 	for (int i = 0; i < fac_size; i++)
@@ -129,7 +215,8 @@ cost vector and a distance matrix row.
 
 Returns nothing, but updates the referenced row with all distances.
 
-Distance calculations are accomplished with a priority queue implementation of single-sink Dijkstra. Note that this
+Distance calculations are accomplished with a priority queue implementation of single-sink Dijkstra. The queue is either
+a radix heap or a binary heap depending on the objective data file (see monotone_queue.hpp). Note that this
 method will be run in parallel for all population centers, and so must rely on mostly local variables, treating all
 other data as read-only.
 */
@@ -155,7 +242,7 @@ void Objective::population_to_all_facilities(int source, const vector<double> &c
 	unordered_set<int> unsearched_sinks; // set of facility node IDs, to be removed as searched as a stopping criterion
 	for (int i = 0; i < fac_size; i++)
 		unsearched_sinks.insert(Net->facility_nodes[i]->id);
-	priority_queue<dist_pair, vector<dist_pair>, greater<dist_pair>> dist_queue; // min-priority queue of distances/IDs
+	MonotoneQueue<int> dist_queue(queue_type); // min-priority queue of distances/IDs
 	dist_queue.push(make_pair(0.0, Net->population_nodes[source]->id)); // init queue with only source node with dist 0
 
 	// Main Dijkstra loop
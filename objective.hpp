@@ -17,7 +17,9 @@ The objective function is implemented as a class equipped with its own attribute
 #include <unordered_set>
 #include <utility>
 #include <vector>
+#include "cancel.hpp"
 #include "definitions.hpp"
+#include "monotone_queue.hpp"
 #include "network.hpp"
 
 using namespace std;
@@ -25,8 +27,6 @@ using namespace concurrency;
 
 extern string FILE_BASE;
 
-typedef pair<double, int> dist_pair; // min-priority queue of distance/ID pairs ordered by first element
-
 /**
 Objective function class.
 
@@ -42,13 +42,19 @@ struct Objective
 	int lowest_metrics = 1; // size of lowest metric set to use for calculating the objective value
 	double gravity_exponent = 1.0; // gravity metric distance falloff exponent (will be made negative for calculations)
 	double multiplier = 1.0; // multiplication factor for metric values
+	int queue_type = QUEUE_RADIX; // priority queue type to use for Dijkstra's algorithm
 	int pop_size; // number of population nodes
 	int fac_size; // number of facility nodes
+	CancelToken * Cancel = NULL; // pointer to the cancellation token (NULL if evaluations cannot be cancelled)
 
 	// Public methods
 	Objective(Network *); // constructor that reads objective function data and sets network object pointer
 	double calculate(const vector<int> &); // calculates objective value
+	vector<double> calculate_batch(const vector<vector<int>> &); // calculates objective values of several solutions
+	double objective_value(vector<double>); // returns the objective value for a given set of gravity metrics
 	vector<double> all_metrics(const vector<int> &); // calculates gravity metrics for all population centers
+	vector<double> core_costs(const vector<int> &); // calculates core arc total costs (base cost plus headway)
+	vector<double> gravity_metrics(vector<vector<double>> &); // calculates gravity metrics from a distance matrix
 	void population_to_all_facilities(int, const vector<double> &, vector<double> &); // distance from given source pop
 	double facility_metric(int, vector<vector<double>> &); // calculates gravity metric for a given facility
 	double population_metric(int, vector<vector<double>> &, vector<double> &); // gravity metric, distance mat, fac met
@@ -2,7 +2,12 @@
 
 #include "search.hpp"
 
-/// Search constructor initializes Network, Objective, and Constraint objects and loads search parameters.
+/**
+Search constructor initializes Network, Objective, and Constraint objects and loads search parameters.
+
+If coarse screening is selected, it also builds the coarse network along with its own Objective object and (optionally)
+Constraint object.
+*/
 Search::Search()
 {
 	Net = new Network(); // network object
@@ -92,6 +97,39 @@ Search::Search()
 			case 16:
 				exhaustive = stoi(piece);
 				break;
+			case 17:
+				coarse_radius = stod(piece);
+				break;
+			case 18:
+				coarse_keep = stoi(piece);
+				break;
+			case 19:
+				coarse_constraint = stoi(piece);
+				break;
+			case 20:
+				snapshot_recent = stoi(piece);
+				break;
+			case 21:
+				lockstep = stoi(piece);
+				break;
+			case 22:
+				cancel.deadline_seconds = stod(piece);
+				break;
+			case 23:
+				concurrency = stoi(piece);
+				break;
+			case 24:
+				sensitivity = stoi(piece);
+				break;
+			case 25:
+				surrogate_neighbors = stoi(piece);
+				break;
+			case 26:
+				surrogate_z = stod(piece);
+				break;
+			case 27:
+				speculation = stoi(piece);
+				break;
 			}
 		}
 
@@ -102,6 +140,56 @@ Search::Search()
 		cout << "Search parameter file failed to open." << endl;
 		exit(FILE_NOT_FOUND);
 	}
+
+	// Store equilibrium flows for warm starts (if selected)
+	Con->snapshots_on = (snapshot_recent > 0);
+
+	// Sensitivities are calculated from the current solution's stored flows, so they require snapshots
+	if ((sensitivity == true) && (snapshot_recent < 1))
+	{
+		cout << "User cost sensitivities require Flow_Snapshots to be at least 1. Sensitivity has been turned off." <<
+			endl;
+		sensitivity = false;
+	}
+
+	// Speculative candidates leave the chosen moves unchanged only if all are warm-started from the same flows
+	if ((speculation > 0) && (snapshot_recent < 1))
+	{
+		cout << "Speculation requires Flow_Snapshots to be at least 1. Speculation has been turned off." << endl;
+		speculation = 0;
+	}
+
+	// Allow the evaluators to be cancelled by a stop request or an expired deadline
+	Obj->Cancel = &cancel;
+	Con->set_cancel(&cancel);
+
+	// Choose between evaluating candidates concurrently and parallelizing each evaluation over its destinations
+	Con->set_concurrency(concurrency);
+	if (Con->contexts.size() > 0)
+		cout << "Evaluating second-pass candidates concurrently in " << Con->contexts.size() << " contexts." << endl;
+
+	// Build the coarse network and its evaluators for first-pass screening (if selected)
+	if (coarse_radius > 0)
+	{
+		if (coarse_keep < 1)
+		{
+			cout << "Coarse screening requires at least one candidate to be promoted in each pass." << endl;
+			exit(INCORRECT_FILE);
+		}
+		CoarseNet = new Network(Net, coarse_radius);
+		CoarseObj = new Objective(CoarseNet);
+		CoarseObj->Cancel = &cancel;
+		cout << "Coarse network has " << CoarseNet->stop_nodes.size() << " of " << Net->stop_nodes.size() <<
+			" stops and " << CoarseNet->core_arcs.size() << " of " << Net->core_arcs.size() << " core arcs." << endl;
+		if (coarse_constraint == true)
+		{
+			// Coarse user costs are bounded relative to the initial solution's coarse user cost
+			CoarseCon = new Constraint(CoarseNet);
+			CoarseCon->Assignment->trace = false; // only the main network's evaluations are traced
+			CoarseCon->calibrate(get_initial_solution().first);
+			CoarseCon->set_cancel(&cancel);
+		}
+	}
 }
 
 /// Search destructor deletes Network, Objective, and Constraint objects created by the constructor.
@@ -110,12 +198,19 @@ Search::~Search()
 	delete Net;
 	delete Obj;
 	delete Con;
+	if (CoarseNet != NULL)
+	{
+		delete CoarseNet;
+		delete CoarseObj;
+		delete CoarseCon;
+	}
 
 	// Only delete logger objects if they have been instantiated
 	if (started == true)
 	{
 		delete EveLog;
 		delete MemLog;
+		delete SolLog->Surrogate;
 		delete SolLog;
 	}
 }
@@ -130,6 +225,12 @@ void Search::solve()
 	MemLog = new MemoryLog(this, pickup);
 	SolLog = new SolutionLog(pickup);
 
+	// Train the feasibility surrogate on the solution log (if selected)
+	if (surrogate_neighbors > 0)
+		SolLog->Surrogate = new FeasibilitySurrogate(SolLog, Con, surrogate_neighbors, surrogate_z);
+	if ((pickup == true) && (Con->snapshots_on == true))
+		Con->load_snapshots();
+
 	// Initialize neighborhood search solution container and set references to its elements
 	neighbor_pair nbhd_sol;
 	pair<int, int> & nbhd_sol1 = nbhd_sol.first.first;
@@ -169,8 +270,13 @@ void Search::solve()
 		cout << "============================================================" << endl << endl;
 		EveLog->iteration = iteration;
 
-		// Perform neighborhood search
+		// Perform neighborhood search, keeping the tabu state that it started from in case it is stopped
+		tenure_start = tenure;
+		add_tenure_start = add_tenure;
+		drop_tenure_start = drop_tenure;
+		searching = true;
 		nbhd_sol = neighborhood_search();
+		searching = false;
 
 		// Break if no moves are available
 		if (nbhd_obj1 == INFINITY)
@@ -312,6 +418,7 @@ void Search::solve()
 
 		// Save data
 		cout << "\n" << (1.0*clock() - start) / CLOCKS_PER_SEC << " seconds spent on iteration." << endl;
+		retain_snapshots();
 		save_data();
 
 		// Safely quit if a keyboard halt has been requested
@@ -344,6 +451,20 @@ void Search::solve()
 	save_data();
 	cout << "Generating metrics for best known solution." << endl;
 	Obj->save_metrics(sol_best);
+
+	// Validate the coarse screening against the logged solutions (if used)
+	if (CoarseNet != NULL)
+	{
+		cout << "Generating coarse screening report." << endl;
+		coarse_report();
+	}
+
+	// Measure the calibration of the feasibility surrogate (if used)
+	if (SolLog->Surrogate != NULL)
+	{
+		cout << "Generating surrogate report." << endl;
+		SolLog->Surrogate->report();
+	}
 }
 
 /**
@@ -370,6 +491,11 @@ neighbor_pair Search::neighborhood_search()
 	vehicle bound constraints, and then collecting the feasible candidates into vectors of candidate moves. We also
 	calculate the objective values of these candidates.
 
+	If coarse screening is in use, the objectives of new candidates are not calculated immediately. Instead they are
+	ranked by their objective values on the coarse network (after any candidates predicted to be infeasible on the
+	coarse network), and only the best few are promoted to full evaluation. The rest are held back in case the ADD/DROP
+	selection loop repeats.
+
 	In the second pass we go through our candidates from the first pass in ascending order of objective value,
 	evaluating the constraint function value for each and collecting the feasible results into a final candidate vector.
 	If, at the end of the second pass, we have fewer than two feasible solutions, we throw away the tabu rules and start
@@ -380,6 +506,12 @@ neighbor_pair Search::neighborhood_search()
 	vehicle). Because of the potentially large number of possible combinations that could be made, we generate
 	combinations by moving through the ADD and DROP candidate lists in ascending order of objective until obtaining
 	enough feasible SWAP moves.
+
+	Since most of the candidates are thrown away, their constraints are evaluated using the assignment model's loose
+	tolerance profile (if one was specified). Before the best two final moves are returned, any whose feasibility came
+	from the loose profile, a screen, or early termination are re-evaluated using a full assignment at the tight profile
+	(see Constraint::verify()), and are replaced by the next best moves if they turn out to be infeasible. Every
+	solution that the search moves to or keeps as attractive is therefore verified tightly.
 	*/
 
 	/*
@@ -400,6 +532,10 @@ neighbor_pair Search::neighborhood_search()
 	*/
 	candidate_queue add_moves1; // candidate ADD moves after first pass
 	candidate_queue drop_moves1; // candidate DROP moves after first pass
+	screen_list add_screened; // new ADD moves ranked on the coarse network, awaiting full evaluation
+	screen_list drop_screened; // new DROP moves ranked on the coarse network, awaiting full evaluation
+	candidate_queue add_deferred; // new candidate ADD moves predicted to be infeasible, put off until the others
+	candidate_queue drop_deferred; // new candidate DROP moves predicted to be infeasible, put off until the others
 	list<pair<double, pair<int, int>>> add_moves2; // candidate ADD moves after second pass
 	list<pair<double, pair<int, int>>> drop_moves2; // candidate DROP moves after second pass
 	neighbor_queue final_moves; // includes all ADD, DROP, and SWAP moves for final consideration
@@ -414,12 +550,6 @@ neighbor_pair Search::neighborhood_search()
 		add_candidates[i] = i;
 		drop_candidates[i] = i;
 	}
-	random_shuffle(add_candidates.begin(), add_candidates.end());
-	random_shuffle(drop_candidates.begin(), drop_candidates.end());
-
-	// Initialize candidate solution temporary containers
-	vector<int> sol_candidate(sol_size); // candidate solution vector
-	double obj_candidate; // candidate solution objective
 
 	// Initialize counters for the event log
 	int obj_lookups = 0; // number of objectives successfully looked up from the solution log
@@ -427,6 +557,31 @@ neighbor_pair Search::neighborhood_search()
 	int new_obj = 0; // number of new solution log objective entries
 	int new_con = 0; // number of new solution log constraint entries
 
+	// Store the current solution's flows if they are missing (as for the initial solution)
+	if ((Con->snapshots_on == true) && (Con->snapshots.count(sol_current) == 0))
+	{
+		cout << 'v';
+		new_con++;
+		verify_candidate(sol_current);
+	}
+
+	// Screen candidates at loose tolerances, warm-starting each from the current solution's flows
+	Con->set_fidelity(FIDELITY_LOOSE);
+	Con->set_parent(sol_current);
+	random_shuffle(add_candidates.begin(), add_candidates.end());
+	random_shuffle(drop_candidates.begin(), drop_candidates.end());
+
+	// Predict the user cost change of every ADD and DROP move from the current solution's flows (if selected)
+	if (sensitivity == true)
+	{
+		add_uc_change = Con->sensitivities(sol_current, step);
+		drop_uc_change = Con->sensitivities(sol_current, -step);
+	}
+
+	// Initialize candidate solution temporary containers
+	vector<int> sol_candidate(sol_size); // candidate solution vector
+	double obj_candidate; // candidate solution objective
+
 	// ADD/DROP move selection loop
 
 	// Search until finding at least two feasible neighbors (in general we will find many more)
@@ -437,134 +592,185 @@ neighbor_pair Search::neighborhood_search()
 		// ADD move first pass
 
 		// Repeat until reaching our first-pass bound or running out of candidates
-		while ((add_moves1.size() < nbhd_add_lim1) && (add_candidates.size() > 0))
+		while ((add_moves1.size() + add_screened.size() < nbhd_add_lim1) && (add_candidates.size() > 0))
 		{
-			// Pop a random ADD move from the candidate list
-			int choice = add_candidates.back();
-			add_candidates.pop_back();
+			// Select candidates until those awaiting objective evaluation would reach the first-pass bound
+			vector<int> pending; // new candidate ADD lines awaiting objective evaluation, in order of selection
+			while ((add_moves1.size() + add_screened.size() + pending.size() < nbhd_add_lim1) &&
+				(add_candidates.size() > 0))
+			{
+				// Pop a random ADD move from the candidate list
+				int choice = add_candidates.back();
+				add_candidates.pop_back();
 
-			// Skip ADD moves that have already been selected (may occur if the ADD/DROP selection loop repeats)
-			if (add_chosen.count(choice) > 0)
-				continue;
+				// Skip ADD moves that have already been selected (may occur if the ADD/DROP selection loop repeats)
+				if (add_chosen.count(choice) > 0)
+					continue;
 
-			// Filter out moves that would violate a line fleet bound
-			if (sol_current[choice] + step > line_max[choice])
-				// Skip ADD moves that would exceed a line's vehicle bound
-				continue;
-			if (current_vehicles[vehicle_type[choice]] + 1 > max_vehicles[vehicle_type[choice]])
-				// Skip ADD moves that would exceed a total vehicle bound
-				continue;
+				// Filter out moves that would violate a line fleet bound
+				if (sol_current[choice] + step > line_max[choice])
+					// Skip ADD moves that would exceed a line's vehicle bound
+					continue;
+				if (current_vehicles[vehicle_type[choice]] + 1 > max_vehicles[vehicle_type[choice]])
+					// Skip ADD moves that would exceed a total vehicle bound
+					continue;
 
-			// Find objective and logged information for candidate solution
-			cout << 'a';
-			sol_candidate = make_move(choice, NO_ID); // solution vector resulting from chosen ADD
-			bool new_candidate; // whether the candidate is new to the solution log
-			if (SolLog->solution_exists(sol_candidate) == true)
-			{
-				// If the solution is logged already, look up its feasibility status and objective
-				new_candidate = false;
-				obj_lookups++;
-				pair<int, double> info = SolLog->lookup_row_quick(sol_candidate);
-				if ((info.first == FEAS_FALSE) || (info.first == FEAS_BAN))
+				// Find logged information for candidate solution
+				cout << 'a';
+				sol_candidate = make_move(choice, NO_ID); // solution vector resulting from chosen ADD
+				if (SolLog->solution_exists(sol_candidate) == true)
 				{
-					// Skip solutions known to be infeasible and banned solutions
-					con_lookups++;
-					continue;
+					// If the solution is logged already, look up its feasibility status and objective
+					obj_lookups++;
+					pair<int, double> info = SolLog->lookup_row_quick(sol_candidate);
+					if ((info.first == FEAS_FALSE) || (info.first == FEAS_BAN))
+					{
+						// Skip solutions known to be infeasible and banned solutions
+						con_lookups++;
+						continue;
+					}
+
+					// Skip a tabu move, unless it would improve our best known solution
+					if ((add_tenure[choice] > 0) && (info.second >= obj_best))
+						continue;
+
+					// Add candidate move to the first-pass queue and add to list of chosen lines
+					// (solutions whose evaluation was abandoned are evaluated again)
+					add_moves1.push(make_tuple(info.second, make_pair(choice, NO_ID),
+						SolLog->lookup_source(sol_candidate) == CON_SOURCE_ABANDONED));
+					add_chosen.insert(choice);
 				}
-				obj_candidate = info.second;
-			}
-			else
-			{
-				// If the solution is new, calculate its objective and create a tentative log entry
-				new_candidate = true;
-				new_obj++;
-				clock_t start = clock(); // objective calculation timer
-				obj_candidate = Obj->calculate(sol_candidate); // calculate objective value
-				double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // objective calculation time
-				SolLog->create_partial_row(sol_candidate, obj_candidate, candidate_time); // initial sol log entry
+				else if (CoarseNet != NULL)
+				{
+					// If the solution is new, defer its evaluation until it has been ranked on the coarse network
+					add_screened.push_back(make_pair(coarse_score(sol_candidate), make_pair(choice, NO_ID)));
+					add_chosen.insert(choice);
+				}
+				else
+					// If the solution is new, hold it for evaluation along with the other new candidates
+					pending.push_back(choice);
 			}
 
-			// Skip a tabu move, unless it would improve our best known solution
-			if (add_tenure[choice] > 0)
+			// Calculate the objectives of the new candidates together and create tentative log entries
+			vector<vector<int>> batch(pending.size()); // solution vectors of the new candidates
+			for (int i = 0; i < pending.size(); i++)
+				batch[i] = make_move(pending[i], NO_ID);
+			vector<double> obj_batch = batch_objectives(batch); // objective values of the new candidates
+			new_obj += batch.size();
+
+			for (int i = 0; i < pending.size(); i++)
 			{
-				if (obj_candidate >= obj_best)
+				// Skip a tabu move, unless it would improve our best known solution
+				if ((add_tenure[pending[i]] > 0) && (obj_batch[i] >= obj_best))
 					continue;
-			}
 
-			// Add candidate move to the first-pass queue and add to list of chosen lines
-			add_moves1.push(make_tuple(obj_candidate, make_pair(choice, NO_ID), new_candidate));
-			add_chosen.insert(choice);
+				// Add candidate move to the first-pass queue and add to list of chosen lines
+				add_moves1.push(make_tuple(obj_batch[i], make_pair(pending[i], NO_ID), true));
+				add_chosen.insert(pending[i]);
+			}
 		}
+		new_obj += promote_candidates(add_screened, add_moves1, add_chosen);
 		EveLog->add_first += add_moves1.size();
 
 		// DROP move first pass
 
 		// Repeat until reaching our first-pass bound or running out of candidates
-		while ((drop_moves1.size() < nbhd_drop_lim1) && (drop_candidates.size() > 0))
+		while ((drop_moves1.size() + drop_screened.size() < nbhd_drop_lim1) && (drop_candidates.size() > 0))
 		{
-			// Pop a random DROP move from the candidate list
-			int choice = drop_candidates.back();
-			drop_candidates.pop_back();
+			// Select candidates until those awaiting objective evaluation would reach the first-pass bound
+			vector<int> pending; // new candidate DROP lines awaiting objective evaluation, in order of selection
+			while ((drop_moves1.size() + drop_screened.size() + pending.size() < nbhd_drop_lim1) &&
+				(drop_candidates.size() > 0))
+			{
+				// Pop a random DROP move from the candidate list
+				int choice = drop_candidates.back();
+				drop_candidates.pop_back();
 
-			// Skip DROP moves that have already been selected (may occur if the ADD/DROP selection loop repeats)
-			if (drop_chosen.count(choice) > 0)
-				continue;
+				// Skip DROP moves that have already been selected (may occur if the ADD/DROP selection loop repeats)
+				if (drop_chosen.count(choice) > 0)
+					continue;
 
-			// Filter out moves that would violate a line fleet bound
-			if (sol_current[choice] - step < line_min[choice])
-				// Skip DROP moves that would fall below a line's vehicle bound
-				continue;
-			if (current_vehicles[vehicle_type[choice]] - 1 < 0)
-				// Skip DROP moves that would result in negative vehicles
-				continue;
+				// Filter out moves that would violate a line fleet bound
+				if (sol_current[choice] - step < line_min[choice])
+					// Skip DROP moves that would fall below a line's vehicle bound
+					continue;
+				if (current_vehicles[vehicle_type[choice]] - 1 < 0)
+					// Skip DROP moves that would result in negative vehicles
+					continue;
 
-			// Find objective and logged information for candidate solution
-			cout << 'd';
-			sol_candidate = make_move(NO_ID, choice); // solution vector resulting from chosen DROP
-			bool new_candidate; // whether the candidate is new to the solution log
-			if (SolLog->solution_exists(sol_candidate) == true)
-			{
-				// If the solution is logged already, look up its feasibility status and objective
-				new_candidate = false;
-				obj_lookups++;
-				pair<int, double> info = SolLog->lookup_row_quick(sol_candidate);
-				if ((info.first == FEAS_FALSE) || (info.first == FEAS_BAN))
+				// Find logged information for candidate solution
+				cout << 'd';
+				sol_candidate = make_move(NO_ID, choice); // solution vector resulting from chosen DROP
+				if (SolLog->solution_exists(sol_candidate) == true)
 				{
-					// Skip solutions known to be infeasible and banned solutions
-					con_lookups++;
-					continue;
+					// If the solution is logged already, look up its feasibility status and objective
+					obj_lookups++;
+					pair<int, double> info = SolLog->lookup_row_quick(sol_candidate);
+					if ((info.first == FEAS_FALSE) || (info.first == FEAS_BAN))
+					{
+						// Skip solutions known to be infeasible and banned solutions
+						con_lookups++;
+						continue;
+					}
+
+					// Skip a tabu move, unless it would improve our best known solution
+					if ((drop_tenure[choice] > 0) && (info.second >= obj_best))
+						continue;
+
+					// Add candidate move to the first-pass queue and add to list of chosen lines
+					// (solutions whose evaluation was abandoned are evaluated again)
+					drop_moves1.push(make_tuple(info.second, make_pair(NO_ID, choice),
+						SolLog->lookup_source(sol_candidate) == CON_SOURCE_ABANDONED));
+					drop_chosen.insert(choice);
 				}
-				obj_candidate = info.second;
-			}
-			else
-			{
-				// If the solution is new, calculate its objective and create a tentative log entry
-				new_candidate = true;
-				new_obj++;
-				clock_t start = clock(); // objective calculation timer
-				obj_candidate = Obj->calculate(sol_candidate); // calculate objective value
-				double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // objective calculation time
-				SolLog->create_partial_row(sol_candidate, obj_candidate, candidate_time); // create init sol log entry
+				else if (CoarseNet != NULL)
+				{
+					// If the solution is new, defer its evaluation until it has been ranked on the coarse network
+					drop_screened.push_back(make_pair(coarse_score(sol_candidate), make_pair(NO_ID, choice)));
+					drop_chosen.insert(choice);
+				}
+				else
+					// If the solution is new, hold it for evaluation along with the other new candidates
+					pending.push_back(choice);
 			}
 
-			// Skip a tabu move, unless it would improve our best known solution
-			if (drop_tenure[choice] > 0)
+			// Calculate the objectives of the new candidates together and create tentative log entries
+			vector<vector<int>> batch(pending.size()); // solution vectors of the new candidates
+			for (int i = 0; i < pending.size(); i++)
+				batch[i] = make_move(NO_ID, pending[i]);
+			vector<double> obj_batch = batch_objectives(batch); // objective values of the new candidates
+			new_obj += batch.size();
+
+			for (int i = 0; i < pending.size(); i++)
 			{
-				if (obj_candidate >= obj_best)
+				// Skip a tabu move, unless it would improve our best known solution
+				if ((drop_tenure[pending[i]] > 0) && (obj_batch[i] >= obj_best))
 					continue;
-			}
 
-			// Add candidate move to the first-pass queue and add to list of chosen lines
-			drop_moves1.push(make_tuple(obj_candidate, make_pair(NO_ID, choice), new_candidate));
-			drop_chosen.insert(choice);
+				// Add candidate move to the first-pass queue and add to list of chosen lines
+				drop_moves1.push(make_tuple(obj_batch[i], make_pair(NO_ID, pending[i]), true));
+				drop_chosen.insert(pending[i]);
+			}
 		}
+		new_obj += promote_candidates(drop_screened, drop_moves1, drop_chosen);
 		EveLog->drop_first += drop_moves1.size();
 
 		// ADD move second pass
 
+		// Put off the new candidates predicted to be infeasible until the others have been evaluated
+		add_deferred = defer_predicted(add_moves1);
+
+		// Evaluate new candidates together (if selected), which leaves nothing for the loop below
+		if ((lockstep == true) || (Con->contexts.size() > 0) || (speculation > 0))
+			new_con += lockstep_pass(add_moves1, add_deferred, add_moves2, nbhd_add_lim2, final_moves, con_lookups);
+
 		// Repeat until reaching our second-pass bound or running out of first-pass candidates
-		while ((add_moves1.size() > 0) && (add_moves2.size() < nbhd_add_lim2))
+		while (((add_moves1.size() > 0) || (add_deferred.size() > 0)) && (add_moves2.size() < nbhd_add_lim2))
 		{
+			// Move on to the deferred candidates once the others have run out
+			if (add_moves1.empty() == true)
+				add_moves1.swap(add_deferred);
+
 			// Pop the best candidate out of the first-pass move list
 			tuple<double, pair<int, int>, bool> move_triple = add_moves1.top();
 			add_moves1.pop();
@@ -577,9 +783,11 @@ neighbor_pair Search::neighborhood_search()
 				clock_t start = clock(); // constraint calculation timer
 				pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // feas status and con vector
 				double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
-				SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time); // log
-				if (con_candidate.first == FEAS_FALSE)
-					// Skip candidate if we've discovered that it is infeasible
+				stop_check();
+				SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time,
+					Con->source, Con->fidelity); // log
+				if ((con_candidate.first == FEAS_FALSE) || (Con->source == CON_SOURCE_ABANDONED))
+					// Skip candidate if we've discovered that it is infeasible or its evaluation was abandoned
 					continue;
 			}
 			else
@@ -589,13 +797,25 @@ neighbor_pair Search::neighborhood_search()
 			add_moves2.push_back(make_pair(get<0>(move_triple), get<1>(move_triple)));
 			final_moves.push(make_pair(get<0>(move_triple), get<1>(move_triple)));
 		}
+		restore_deferred(add_moves1, add_deferred);
 		EveLog->add_second += add_moves2.size();
 
 		// DROP move second pass
 
+		// Put off the new candidates predicted to be infeasible until the others have been evaluated
+		drop_deferred = defer_predicted(drop_moves1);
+
+		// Evaluate new candidates together (if selected), which leaves nothing for the loop below
+		if ((lockstep == true) || (Con->contexts.size() > 0) || (speculation > 0))
+			new_con += lockstep_pass(drop_moves1, drop_deferred, drop_moves2, nbhd_drop_lim2, final_moves, con_lookups);
+
 		// Repeat until reaching our second-pass bound or running out of first-pass candidates
-		while ((drop_moves1.size() > 0) && (drop_moves2.size() < nbhd_drop_lim2))
+		while (((drop_moves1.size() > 0) || (drop_deferred.size() > 0)) && (drop_moves2.size() < nbhd_drop_lim2))
 		{
+			// Move on to the deferred candidates once the others have run out
+			if (drop_moves1.empty() == true)
+				drop_moves1.swap(drop_deferred);
+
 			// Pop the best candidate out of the first-pass move list
 			tuple<double, pair<int, int>, bool> move_triple = drop_moves1.top();
 			drop_moves1.pop();
@@ -608,9 +828,11 @@ neighbor_pair Search::neighborhood_search()
 				clock_t start = clock(); // constraint calculation timer
 				pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // calculate feas and cons
 				double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
-				SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time); // log
-				if (con_candidate.first == FEAS_FALSE)
-					// Skip candidate if we've discovered that it is infeasible
+				stop_check();
+				SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time,
+					Con->source, Con->fidelity); // log
+				if ((con_candidate.first == FEAS_FALSE) || (Con->source == CON_SOURCE_ABANDONED))
+					// Skip candidate if we've discovered that it is infeasible or its evaluation was abandoned
 					continue;
 			}
 			else
@@ -620,10 +842,12 @@ neighbor_pair Search::neighborhood_search()
 			drop_moves2.push_back(make_pair(get<0>(move_triple), get<1>(move_triple)));
 			final_moves.push(make_pair(get<0>(move_triple), get<1>(move_triple)));
 		}
+		restore_deferred(drop_moves1, drop_deferred);
 		EveLog->drop_second += drop_moves2.size();
 
 		// Unsuccessful search handling
-		if (add_moves2.size() + drop_moves2.size() + add_candidates.size() + drop_candidates.size() < 2)
+		if (add_moves2.size() + drop_moves2.size() + add_candidates.size() + drop_candidates.size() +
+			add_screened.size() + drop_screened.size() < 2)
 		{
 			// If there are no longer enough candidates to generate at least two moves, take actions to intensify
 			
@@ -690,6 +914,7 @@ neighbor_pair Search::neighborhood_search()
 		int limit = min(add_moves2.size(), drop_moves2.size()); // smaller of the two candidate list sizes
 		int add_loop = 0; // iteration of outer ADD list loop
 		int drop_loop; // iteration of inner DROP list loop
+		vector<pair<int, int>> deferred_swaps; // new ADD/DROP pairs predicted to be infeasible, in search order
 
 		// Iterate through the ADD list (breaks if we reach a stopping condition)
 		for (list<pair<double, pair<int, int>>>::iterator add_it = add_moves2.begin(); add_it != add_moves2.end();
@@ -753,41 +978,25 @@ neighbor_pair Search::neighborhood_search()
 					}
 					else if (info.first == FEAS_UNKNOWN)
 					{
-						// Calculate constraints for solutions of unknown feasibility
+						// Calculate constraints for solutions of unknown feasibility (including abandoned evaluations)
 						new_con++;
 						clock_t start = clock(); // constraint calculation timer
 						pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // feas and cons
 						double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
-						SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time);
+						stop_check();
+						SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time,
+							Con->source, Con->fidelity);
 					}
 				}
-				else
+				else if (predicted_infeasible(add_id, drop_id) == true)
 				{
-					// If the solution is new, generate all necessary information for the log entry
-
-					// Calculate objective
-					new_obj++;
-					clock_t start = clock(); // objective calculation timer
-					obj_candidate = Obj->calculate(sol_candidate); // calculate objective value
-					double obj_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // objective calculation time
-
-					// Calculate constraints
-					new_con++;
-					start = clock(); // constraint calculation timer
-					pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // calculate feas and cons
-					double con_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
-
-					// Create new solution log entry
-					SolLog->create_row(sol_candidate, con_candidate.first, con_candidate.second, con_time,
-						obj_candidate, obj_time);
-
-					// If the solution is feasible, add it to the candidate list
-					if (con_candidate.first == FEAS_TRUE)
-					{
-						swaps++;
-						final_moves.push(make_pair(obj_candidate, make_pair(add_id, drop_id)));
-					}
+					// Put off new solutions predicted to be infeasible until the search pattern has been exhausted
+					deferred_swaps.push_back(make_pair(add_id, drop_id));
+					continue;
 				}
+				else if (evaluate_swap(add_id, drop_id, final_moves, new_obj, new_con) == true)
+					// If the solution is new and feasible, add it to the candidate list
+					swaps++;
 
 				// Break if have enough SWAP candidates
 				if (swaps >= nbhd_swap_lim)
@@ -796,6 +1005,14 @@ neighbor_pair Search::neighborhood_search()
 
 			add_loop++;
 		}
+
+		// Evaluate the deferred pairs if there are still too few SWAP candidates
+		for (int i = 0; (i < deferred_swaps.size()) && (swaps < nbhd_swap_lim); i++)
+		{
+			cout << 's';
+			if (evaluate_swap(deferred_swaps[i].first, deferred_swaps[i].second, final_moves, new_obj, new_con) == true)
+				swaps++;
+		}
 	}
 	EveLog->swaps = swaps;
 
@@ -803,19 +1020,35 @@ neighbor_pair Search::neighborhood_search()
 	add_moves2.clear();
 	drop_moves2.clear();
 
-	// Return the two best solutions from the final move queue (filling missing solutions with placeholders)
+	// Verify the best moves with full tight assignments, skipping any that turn out to be infeasible
+	Con->set_fidelity(FIDELITY_TIGHT);
+	vector<pair<pair<int, int>, double>> verified; // best two verified moves and their objectives
+	while ((final_moves.empty() == false) && (verified.size() < 2))
+	{
+		pair<double, pair<int, int>> move = final_moves.top();
+		final_moves.pop();
+		sol_candidate = make_move(move.second.first, move.second.second);
+		if (unverified(sol_candidate) == true)
+		{
+			new_con++;
+			if (verify_candidate(sol_candidate) == false)
+				continue;
+		}
+		verified.push_back(make_pair(move.second, move.first));
+	}
+
+	// Return the two best solutions from the verified moves (filling missing solutions with placeholders)
 	pair<pair<int, int>, double> neighbor1;
 	pair<pair<int, int>, double> neighbor2;
 
-	if (final_moves.empty() == false)
+	if (verified.size() > 0)
 	{
 		// If there is a best neighbor, record it
-		neighbor1 = make_pair(final_moves.top().second, final_moves.top().first);
-		final_moves.pop();
+		neighbor1 = verified[0];
 
-		if (final_moves.empty() == false)
+		if (verified.size() > 1)
 			// If there is a second best neighbor, record it
-			neighbor2 = make_pair(final_moves.top().second, final_moves.top().first);
+			neighbor2 = verified[1];
 		else
 		{
 			// If there was only one feasible neighbor, output null second solution and ban the current solution
@@ -862,6 +1095,169 @@ vector<int> Search::make_move(int add_id, int drop_id)
 	return sol;
 }
 
+/**
+Scores a solution on the coarse network for coarse screening.
+
+Requires a solution vector.
+
+Returns a pair whose first element indicates whether the solution is predicted to be infeasible (always false if coarse
+feasibility prediction is not used) and whose second element is its objective value on the coarse network. Sorting
+these pairs in ascending order ranks the solutions predicted to be feasible first, in ascending order of objective.
+*/
+pair<bool, double> Search::coarse_score(const vector<int> &sol)
+{
+	bool infeasible = false;
+	if (CoarseCon != NULL)
+		infeasible = (CoarseCon->calculate(sol).first == FEAS_FALSE);
+	double obj = CoarseObj->calculate(sol); // coarse objective value
+	stop_check();
+	return make_pair(infeasible, obj);
+}
+
+/**
+Calculates the objectives of several new solutions together and creates their tentative solution log entries.
+
+Requires a vector of solution vectors.
+
+Returns a vector of their objective values, in the same order (see Objective::calculate_batch()). Each solution is
+logged with an equal share of the total objective calculation time.
+
+The first pass of the neighborhood search selects its candidates in random order, applying the bound, solution log, and
+coarse screening filters as it goes, and holds the new ones for evaluation until they would fill the first-pass bound.
+Only the tabu rule depends on the objective, so it is applied afterward, and any candidates that it rejects are replaced
+by another round of selection. The candidates chosen are thus exactly those that would be chosen by evaluating them one
+at a time, while each round's objectives are calculated together.
+*/
+vector<double> Search::batch_objectives(const vector<vector<int>> &sols)
+{
+	if (sols.empty() == true)
+		return vector<double>();
+
+	clock_t start = clock(); // objective calculation timer
+	vector<double> objectives = Obj->calculate_batch(sols); // objective values
+	double obj_time = (1.0*clock() - start) / CLOCKS_PER_SEC / sols.size(); // objective calculation time share
+	stop_check();
+	for (int i = 0; i < sols.size(); i++)
+		SolLog->create_partial_row(sols[i], objectives[i], obj_time); // initial sol log entry
+
+	return objectives;
+}
+
+/**
+Promotes the most promising coarse-screened candidate moves to full evaluation.
+
+Requires references to a list of screened moves, the first-pass queue to promote them into, and the set of chosen lines
+for their move type.
+
+Moves are taken from the list in ascending order of their coarse scores until the promotion limit is reached or the list
+runs out. The objective of each promoted move is calculated on the full network and logged, after which the usual tabu
+rule is applied. Tabu moves are released from the set of chosen lines, just as they would be without screening. Moves
+left in the list remain available for later passes. The objectives are calculated together, in windows of as many moves
+as could still be promoted (see batch_objectives()), so the same moves are promoted as if they were taken one at a time.
+
+Returns the number of full objective evaluations.
+*/
+int Search::promote_candidates(screen_list &screened, candidate_queue &moves, unordered_set<int> &chosen)
+{
+	screened.sort();
+	int promoted = 0; // number of moves added to the first-pass queue
+	int evaluated = 0; // number of full objective evaluations
+
+	while ((promoted < coarse_keep) && (screened.size() > 0))
+	{
+		// Take as many of the best-ranked moves as could still be promoted
+		vector<pair<int, int>> window; // moves taken from the front of the list
+		vector<vector<int>> batch; // solution vectors resulting from the moves
+		while ((promoted + window.size() < coarse_keep) && (screened.size() > 0))
+		{
+			window.push_back(screened.front().second);
+			screened.pop_front();
+			batch.push_back(make_move(window.back().first, window.back().second));
+		}
+
+		// Calculate the objectives together and create tentative log entries
+		vector<double> obj_batch = batch_objectives(batch); // objective values of the moves
+		evaluated += batch.size();
+
+		for (int i = 0; i < window.size(); i++)
+		{
+			// Skip a tabu move, unless it would improve our best known solution
+			pair<int, int> move = window[i];
+			double move_tenure = (move.first != NO_ID) ? add_tenure[move.first] : drop_tenure[move.second];
+			if ((move_tenure > 0) && (obj_batch[i] >= obj_best))
+			{
+				chosen.erase((move.first != NO_ID) ? move.first : move.second);
+				continue;
+			}
+
+			moves.push(make_tuple(obj_batch[i], move, true));
+			promoted++;
+		}
+	}
+
+	return evaluated;
+}
+
+/**
+Returns whether the logged constraint results of a solution have yet to be confirmed by a full tight assignment.
+
+Requires a solution vector, which should already be logged.
+
+Results found at loose tolerances, by a screen, or by early termination (see Constraint::calculate()) are only estimates
+of which side of the user cost bound the solution lies on, and so are unverified.
+*/
+bool Search::unverified(const vector<int> &sol)
+{
+	return ((SolLog->lookup_fidelity(sol) == FIDELITY_LOOSE) || (SolLog->lookup_source(sol) != CON_SOURCE_FULL));
+}
+
+/**
+Confirms the feasibility of a candidate solution using a full assignment at tight tolerances (see Constraint::verify()).
+
+Requires a solution vector, which should already be logged.
+
+The solution's log entry is updated with the results. Returns true unless the solution turns out to be infeasible or its
+evaluation is abandoned.
+*/
+bool Search::verify_candidate(const vector<int> &sol)
+{
+	clock_t start = clock(); // constraint calculation timer
+	pair<int, vector<double>> con_candidate = Con->verify(sol); // calculate feas and cons
+	double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
+	stop_check();
+	SolLog->update_row(sol, con_candidate.first, con_candidate.second, candidate_time, Con->source, Con->fidelity);
+	return ((con_candidate.first != FEAS_FALSE) && (Con->source != CON_SOURCE_ABANDONED));
+}
+
+/**
+Safely quits in the middle of an iteration if a stop has been requested.
+
+Called after every objective and constraint evaluation made during the search, before its results are used. Once a stop
+has been requested the evaluators return as soon as they can with incomplete results (see cancel.hpp), so rather than
+finishing the iteration with a series of useless evaluations, the unfinished iteration is discarded and the search
+memory is saved as of the end of the previous iteration, along with every completed evaluation. The neighborhood search
+may already have reset or decremented the tabu tenures, so they are restored to the values that it started from. The
+discarded iteration is repeated if the search is continued.
+*/
+void Search::stop_check()
+{
+	if (cancel.stop_requested() == false)
+		return;
+
+	cout << "\nEvaluation stopped. Discarding the current iteration." << endl;
+	if (searching == true)
+	{
+		iteration--;
+		tenure = tenure_start;
+		add_tenure.swap(add_tenure_start);
+		drop_tenure.swap(drop_tenure_start);
+	}
+	EveLog->halt();
+	retain_snapshots();
+	save_data();
+	exit(KEYBOARD_HALT);
+}
+
 /**
 Deletes a random solution from the attractive solution set, and optionally sets it as the current solution.
 
@@ -908,11 +1304,350 @@ void Search::cool_temperature()
 	temperature *= temp_factor;
 }
 
+/**
+Carries out a second pass of the neighborhood search by evaluating the constraints of new candidates together.
+
+Requires references to a first-pass candidate queue, its queue of deferred candidates (see defer_predicted()), the
+second-pass move list to fill from them, the second-pass limit, the final move queue, and the count of constraint
+lookups, respectively.
+
+Candidates are taken from the queue in ascending order of objective, just as in the ordinary second pass, but in windows
+of as many candidates as could still be added to the move list. The new candidates in each window are evaluated together
+(see Constraint::calculate_batch()), and then the feasible candidates are added in order. Since a window never holds
+more candidates than the move list still needs, the candidates evaluated are exactly the same as those of the ordinary
+second pass. Each new candidate is logged with an equal share of its window's evaluation time. The deferred candidates
+are taken in the same way once the first queue has run out.
+
+If speculation is selected then each window also holds up to that many further candidates, which are evaluated in case
+earlier candidates in the window turn out to be infeasible. This keeps more processors busy (or more fleets advancing in
+each lockstep round) when the move list needs only a few more candidates. The results are still committed in order, so
+the moves added are the same as without speculation. This relies on every candidate being warm-started from the current
+solution's stored flows (see Constraint::set_parent()), since otherwise each one's result would depend on which
+candidate was evaluated before it, so speculation requires flow snapshots and is skipped while the current solution has
+no stored flows. Once the move list is full, the remaining candidates in the window are returned to the queue, now as
+logged solutions, unless they turned out to be infeasible or were abandoned, in which case they would never have been
+added anyway. Their results stay in the solution log for later neighborhood searches.
+
+This is used for lockstep evaluation and for concurrent evaluation, which Constraint::calculate_batch() chooses between,
+as well as for speculation.
+
+Returns the number of new constraint evaluations.
+*/
+int Search::lockstep_pass(candidate_queue &moves1, candidate_queue &deferred,
+	list<pair<double, pair<int, int>>> &moves2, int limit, neighbor_queue &final_moves, int &con_lookups)
+{
+	int evaluations = 0; // number of new constraint evaluations
+	int extra = (Con->parent_pair.first.empty() == true) ? 0 : speculation; // speculative candidates per window
+	while (((moves1.size() > 0) || (deferred.size() > 0)) && (moves2.size() < limit))
+	{
+		// Move on to the deferred candidates once the others have run out
+		if (moves1.empty() == true)
+			moves1.swap(deferred);
+
+		// Pop as many candidates as could still be added to the move list (plus any speculative candidates)
+		vector<tuple<double, pair<int, int>, bool>> window; // candidates in ascending order of objective
+		vector<vector<int>> batch; // new solution vectors in the window
+		while ((moves1.size() > 0) && (window.size() + moves2.size() < limit + extra))
+		{
+			window.push_back(moves1.top());
+			moves1.pop();
+			if (get<2>(window.back()) == true)
+				batch.push_back(make_move(get<1>(window.back()).first, get<1>(window.back()).second));
+		}
+
+		// Calculate the constraint function values of all new solutions together
+		clock_t start = clock(); // constraint calculation timer
+		vector<pair<int, vector<double>>> con_batch = Con->calculate_batch(batch); // feas status and con vectors
+		double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC / max((int) batch.size(), 1); // time share
+		stop_check();
+
+		// Log the new solutions and add the feasible candidates to the move list and the final move queue
+		int b = 0; // position in the batch
+		for (int i = 0; i < window.size(); i++)
+		{
+			if (get<2>(window[i]) == true)
+			{
+				evaluations++;
+				SolLog->update_row(batch[b], con_batch[b].first, con_batch[b].second, candidate_time, Con->sources[b],
+					Con->fidelity); // log
+				b++;
+				if ((con_batch[b - 1].first == FEAS_FALSE) || (Con->sources[b - 1] == CON_SOURCE_ABANDONED))
+					// Skip candidate if we've discovered that it is infeasible or its evaluation was abandoned
+					continue;
+			}
+
+			// Return speculative candidates that are no longer needed to the queue, where they are now logged
+			if (moves2.size() >= limit)
+			{
+				moves1.push(make_tuple(get<0>(window[i]), get<1>(window[i]), false));
+				continue;
+			}
+
+			if (get<2>(window[i]) == false)
+				con_lookups++;
+			moves2.push_back(make_pair(get<0>(window[i]), get<1>(window[i])));
+			final_moves.push(make_pair(get<0>(window[i]), get<1>(window[i])));
+		}
+	}
+
+	return evaluations;
+}
+
+/**
+Decides whether a move from the current solution is predicted to be infeasible.
+
+Requires an ADD line ID and a DROP line ID. Use an ID of "NO_ID" to ignore one of the move types.
+
+Two predictions are available. For the user cost sensitivities, the predicted user cost changes of the ADD and DROP are
+added together and compared to the current solution's margin below the user cost bound (see
+Constraint::sensitivities()). The feasibility surrogate instead predicts the user cost of the resulting solution from
+the logged solutions near it (see FeasibilitySurrogate), and only counts if it is confident. Returns false if neither is
+used.
+*/
+bool Search::predicted_infeasible(int add_id, int drop_id)
+{
+	// User cost sensitivities
+	if (sensitivity == true)
+	{
+		double margin = Con->sensitivity_margin; // predicted margin below the user cost bound
+		if (add_id != NO_ID)
+			margin -= add_uc_change[add_id];
+		if (drop_id != NO_ID)
+			margin -= drop_uc_change[drop_id];
+		if (margin < 0)
+			return true;
+	}
+
+	// Feasibility surrogate
+	if ((SolLog->Surrogate != NULL) && (SolLog->Surrogate->confidently_infeasible(make_move(add_id, drop_id)) == true))
+		return true;
+
+	return false;
+}
+
+/**
+Removes the new candidates that are predicted to be infeasible from a first-pass candidate queue.
+
+Requires a reference to the queue.
+
+Returns a queue of the removed candidates. Both queues remain ordered by objective, so a second pass that takes the
+deferred candidates only after the others evaluates the candidates in order of predicted feasibility and then objective.
+The predictions are only first-order, so the deferred candidates are put off rather than discarded. Logged candidates
+need no constraint evaluation and are never deferred.
+*/
+candidate_queue Search::defer_predicted(candidate_queue &moves)
+{
+	candidate_queue kept; // candidates that are logged or predicted to be feasible
+	candidate_queue deferred; // new candidates predicted to be infeasible
+	while (moves.empty() == false)
+	{
+		tuple<double, pair<int, int>, bool> move_triple = moves.top();
+		moves.pop();
+		if ((get<2>(move_triple) == true) &&
+			(predicted_infeasible(get<1>(move_triple).first, get<1>(move_triple).second) == true))
+			deferred.push(move_triple);
+		else
+			kept.push(move_triple);
+	}
+	moves.swap(kept);
+
+	return deferred;
+}
+
+/**
+Returns the unused deferred candidates to their first-pass candidate queue.
+
+Requires references to the first-pass queue and its deferred queue, respectively.
+
+The first-pass queue is kept across repetitions of the ADD/DROP selection loop, so any candidates left over after a
+second pass must go back into it to remain available.
+*/
+void Search::restore_deferred(candidate_queue &moves, candidate_queue &deferred)
+{
+	while (deferred.empty() == false)
+	{
+		moves.push(deferred.top());
+		deferred.pop();
+	}
+}
+
+/**
+Calculates and logs the objective and constraints of a new SWAP candidate.
+
+Requires the ADD and DROP line IDs, followed by references to the final move queue and the counts of new objective and
+constraint evaluations, respectively.
+
+Returns whether the candidate is feasible, in which case it is also added to the final move queue.
+*/
+bool Search::evaluate_swap(int add_id, int drop_id, neighbor_queue &final_moves, int &new_obj, int &new_con)
+{
+	vector<int> sol_candidate = make_move(add_id, drop_id); // candidate solution vector
+
+	// Calculate objective
+	new_obj++;
+	clock_t start = clock(); // objective calculation timer
+	double obj_candidate = Obj->calculate(sol_candidate); // calculate objective value
+	double obj_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // objective calculation time
+	stop_check();
+
+	// Calculate constraints
+	new_con++;
+	start = clock(); // constraint calculation timer
+	pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // calculate feas and cons
+	double con_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
+	stop_check();
+
+	// Create new solution log entry
+	SolLog->create_row(sol_candidate, con_candidate.first, con_candidate.second, con_time, obj_candidate, obj_time,
+		Con->source, Con->fidelity);
+
+	// If the solution is feasible, add it to the candidate list
+	if (con_candidate.first == FEAS_TRUE)
+	{
+		final_moves.push(make_pair(obj_candidate, make_pair(add_id, drop_id)));
+		return true;
+	}
+	return false;
+}
+
+/**
+Keeps the stored equilibrium flows of the solutions that future neighborhood searches are likely to start from.
+
+These are the current solution and the most recent accepted solutions before it (up to the Flow_Snapshots search
+parameter in total), the best known solution, and the attractive solutions. All other stored flows are deleted.
+*/
+void Search::retain_snapshots()
+{
+	if (Con->snapshots_on == false)
+		return;
+
+	// Record the current solution as the most recently accepted solution
+	if ((recent_solutions.empty() == true) || (recent_solutions.front() != sol_current))
+		recent_solutions.push_front(sol_current);
+	while (recent_solutions.size() > snapshot_recent)
+		recent_solutions.pop_back();
+
+	// Collect all solutions to keep
+	vector<vector<int>> keep(recent_solutions.begin(), recent_solutions.end());
+	keep.push_back(sol_best);
+	for (auto it = attractive_solutions.begin(); it != attractive_solutions.end(); it++)
+		keep.push_back(it->first);
+	Con->keep_snapshots(keep);
+}
+
 /// Writes current memory structures to the output logs.
 void Search::save_data()
 {
 	MemLog->save_memory();
 	SolLog->save_solution();
+	if (Con->snapshots_on == true)
+		Con->save_snapshots();
+}
+
+/**
+Writes a validation report comparing the coarse and full network rankings of all logged solutions.
+
+Every logged solution with a finite objective is evaluated on the coarse network, and both sets of objective values are
+converted into ranks. The report begins with a summary of:
+	the number of solutions compared
+	the Spearman rank correlation between the full and coarse objectives
+	the fraction of the best solutions on the full network (as many as are promoted by each pass) that are also among
+		the best on the coarse network
+	the fraction of solutions with known feasibility whose coarse feasibility prediction agrees (-1 if unused)
+	the mean full objective time, and the mean coarse screening time
+This is followed by a row for each solution.
+*/
+void Search::coarse_report()
+{
+	// Evaluate logged solutions on the coarse network
+	vector<string> sols; // solution strings
+	vector<double> obj; // full objective values
+	vector<double> coarse_obj; // coarse objective values
+	vector<int> feas; // logged feasibility statuses
+	vector<int> coarse_feas; // coarse feasibility predictions
+	double obj_time = 0.0; // total full objective time
+	double coarse_time = 0.0; // total coarse screening time
+	for (auto it = SolLog->sol_log.begin(); it != SolLog->sol_log.end(); it++)
+	{
+		if (isfinite(get<SOL_LOG_OBJ>(it->second)) == false)
+			continue;
+		vector<int> sol = str2vec(it->first);
+		sols.push_back(it->first);
+		obj.push_back(get<SOL_LOG_OBJ>(it->second));
+		feas.push_back(get<SOL_LOG_FEAS>(it->second));
+		obj_time += get<SOL_LOG_OBJ_TIME>(it->second);
+
+		clock_t start = clock(); // coarse screening timer
+		pair<bool, double> score = coarse_score(sol);
+		coarse_time += (1.0*clock() - start) / CLOCKS_PER_SEC;
+		coarse_obj.push_back(score.second);
+		if (CoarseCon != NULL)
+			coarse_feas.push_back((score.first == true) ? FEAS_FALSE : FEAS_TRUE);
+		else
+			coarse_feas.push_back(FEAS_UNKNOWN);
+	}
+	int n = sols.size(); // number of solutions compared
+	vector<double> rank = average_ranks(obj); // full objective ranks
+	vector<double> coarse_rank = average_ranks(coarse_obj); // coarse objective ranks
+
+	// Spearman correlation (Pearson correlation of the ranks)
+	double mean = (n + 1) / 2.0; // mean rank
+	double cov = 0.0, var = 0.0, coarse_var = 0.0;
+	for (int i = 0; i < n; i++)
+	{
+		cov += (rank[i] - mean)*(coarse_rank[i] - mean);
+		var += (rank[i] - mean)*(rank[i] - mean);
+		coarse_var += (coarse_rank[i] - mean)*(coarse_rank[i] - mean);
+	}
+	double spearman = cov / sqrt(var*coarse_var);
+
+	// Overlap of the best solutions (including any ties) and agreement of feasibility predictions
+	int top = min(coarse_keep, n); // number of best solutions to compare
+	vector<double> sorted_obj = obj; // full objectives in ascending order
+	vector<double> sorted_coarse = coarse_obj; // coarse objectives in ascending order
+	sort(sorted_obj.begin(), sorted_obj.end());
+	sort(sorted_coarse.begin(), sorted_coarse.end());
+	int best = 0; // best full solutions
+	int overlap = 0; // best full solutions that are also among the best coarse solutions
+	int known = 0; // solutions with known feasibility and a coarse prediction
+	int agree = 0; // solutions whose coarse prediction matches their known feasibility
+	for (int i = 0; i < n; i++)
+	{
+		if ((top > 0) && (obj[i] <= sorted_obj[top - 1]))
+		{
+			best++;
+			if (coarse_obj[i] <= sorted_coarse[top - 1])
+				overlap++;
+		}
+		if ((feas[i] != FEAS_UNKNOWN) && (coarse_feas[i] != FEAS_UNKNOWN))
+		{
+			known++;
+			if ((feas[i] == FEAS_FALSE) == (coarse_feas[i] == FEAS_FALSE))
+				agree++;
+		}
+	}
+
+	// Write report
+	ofstream report_file(FILE_BASE + COARSE_REPORT_FILE);
+	if (report_file.is_open())
+	{
+		report_file << fixed << setprecision(15);
+		report_file << "Label\tValue" << endl;
+		report_file << "Solutions\t" << n << endl;
+		report_file << "Spearman\t" << spearman << endl;
+		report_file << "Top_Overlap\t" << ((best > 0) ? (1.0*overlap) / best : -1.0) << endl;
+		report_file << "Feasibility_Agreement\t" << ((known > 0) ? (1.0*agree) / known : -1.0) << endl;
+		report_file << "Obj_Time\t" << ((n > 0) ? obj_time / n : 0.0) << endl;
+		report_file << "Coarse_Time\t" << ((n > 0) ? coarse_time / n : 0.0) << endl;
+		report_file << "Solution\tObjective\tCoarse_Objective\tRank\tCoarse_Rank\tFeasible\tCoarse_Feasible" << endl;
+		for (int i = 0; i < n; i++)
+			report_file << sols[i] << '\t' << obj[i] << '\t' << coarse_obj[i] << '\t' << rank[i] << '\t' <<
+				coarse_rank[i] << '\t' << feas[i] << '\t' << coarse_feas[i] << endl;
+		report_file.close();
+		cout << "Coarse screening Spearman correlation over " << n << " logged solutions: " << spearman << endl;
+	}
+	else
+		cout << "Failed to write coarse screening report." << endl;
 }
 
 /**
@@ -927,6 +1662,9 @@ This is for use in an exhaustive local search. Every possible ADD and DROP move
 */
 pair<pair<int, int>, double> Search::best_neighbor()
 {
+	// Warm-start each neighbor from the current solution's flows
+	Con->set_parent(sol_current);
+
 	// Current best known neighbor objective and move
 	pair<int, int> top_move = make_pair(NO_ID, NO_ID);
 	double top_objective = INFINITY;
@@ -956,6 +1694,9 @@ pair<pair<int, int>, double> Search::best_neighbor()
 			if (feas == FEAS_FALSE)
 				// Skip solutions known to be infeasible
 				continue;
+			if ((feas == FEAS_TRUE) && (unverified(sol_candidate) == true))
+				// Recalculate the constraints of solutions whose feasibility has not been confirmed
+				feas = FEAS_UNKNOWN;
 			obj_candidate = info.second;
 		}
 		else
@@ -965,6 +1706,7 @@ pair<pair<int, int>, double> Search::best_neighbor()
 			clock_t start = clock(); // objective calculation timer
 			obj_candidate = Obj->calculate(sol_candidate); // calculate objective value
 			double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // objective calculation time
+			stop_check();
 			SolLog->create_partial_row(sol_candidate, obj_candidate, candidate_time); // create initial sol log entry
 		}
 
@@ -979,9 +1721,14 @@ pair<pair<int, int>, double> Search::best_neighbor()
 			clock_t start = clock(); // constraint calculation timer
 			pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // calculate feas status and cons
 			double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
-			SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time); // log
-			if (con_candidate.first == FEAS_FALSE)
-				// Skip candidate if discovered to be infeasible
+			stop_check();
+			SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time,
+				Con->source, Con->fidelity); // log
+			if ((con_candidate.first == FEAS_FALSE) || (Con->source == CON_SOURCE_ABANDONED))
+				// Skip candidate if discovered to be infeasible or if its evaluation was abandoned
+				continue;
+			if ((unverified(sol_candidate) == true) && (verify_candidate(sol_candidate) == false))
+				// Skip candidate if its feasibility is not confirmed by a full assignment
 				continue;
 		}
 
@@ -1016,6 +1763,9 @@ pair<pair<int, int>, double> Search::best_neighbor()
 			if (feas == FEAS_FALSE)
 				// Skip solutions known to be infeasible
 				continue;
+			if ((feas == FEAS_TRUE) && (unverified(sol_candidate) == true))
+				// Recalculate the constraints of solutions whose feasibility has not been confirmed
+				feas = FEAS_UNKNOWN;
 			obj_candidate = info.second;
 		}
 		else
@@ -1025,6 +1775,7 @@ pair<pair<int, int>, double> Search::best_neighbor()
 			clock_t start = clock(); // objective calculation timer
 			obj_candidate = Obj->calculate(sol_candidate); // calculate objective value
 			double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // objective calculation time
+			stop_check();
 			SolLog->create_partial_row(sol_candidate, obj_candidate, candidate_time); // create initial sol log entry
 		}
 
@@ -1039,9 +1790,14 @@ pair<pair<int, int>, double> Search::best_neighbor()
 			clock_t start = clock(); // constraint calculation timer
 			pair<int, vector<double>> con_candidate = Con->calculate(sol_candidate); // calculate feas and cons
 			double candidate_time = (1.0*clock() - start) / CLOCKS_PER_SEC; // constraint calculation time
-			SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time); // log
-			if (con_candidate.first == FEAS_FALSE)
-				// Skip candidate if discovered to be infeasible
+			stop_check();
+			SolLog->update_row(sol_candidate, con_candidate.first, con_candidate.second, candidate_time,
+				Con->source, Con->fidelity); // log
+			if ((con_candidate.first == FEAS_FALSE) || (Con->source == CON_SOURCE_ABANDONED))
+				// Skip candidate if discovered to be infeasible or if its evaluation was abandoned
+				continue;
+			if ((unverified(sol_candidate) == true) && (verify_candidate(sol_candidate) == false))
+				// Skip candidate if its feasibility is not confirmed by a full assignment
 				continue;
 		}
 
@@ -1064,6 +1820,9 @@ is achieved.
 */
 void Search::exhaustive_search()
 {
+	// Evaluate all constraints at tight tolerances
+	Con->set_fidelity(FIDELITY_TIGHT);
+
 	// Find best neighbor
 	pair<pair<int, int>, double> move = best_neighbor();
 
@@ -1095,6 +1854,7 @@ void Search::exhaustive_search()
 		EveLog->log_iteration(sol_current);
 
 		// Repeat neighborhood search
+		retain_snapshots();
 		move = best_neighbor();
 	}
 }
@@ -25,6 +25,7 @@ process.
 #include <utility>
 #include <vector>
 #include "definitions.hpp"
+#include "cancel.hpp"
 #include "constraints.hpp"
 #include "network.hpp"
 #include "objective.hpp"
@@ -38,17 +39,20 @@ typedef priority_queue<tuple<double, pair<int, int>, bool>, vector<tuple<double,
 	greater<tuple<double, pair<int, int>, bool>>> candidate_queue; // min-priority queue for obj/move/new tuples
 typedef priority_queue<pair<double, pair<int, int>>, vector<pair<double, pair<int, int>>>, greater<pair<double,
 	pair<int, int>>>> neighbor_queue; // min-priority queue for obj/move pairs at the end of neighborhood search
+typedef list<pair<pair<bool, double>, pair<int, int>>> screen_list; // coarse score/move pairs awaiting promotion
 
 // Global function prototypes
 pair<vector<int>, double> get_initial_solution(); // returns the initial solution vector and objective value
 string vec2str(const vector<int> &); // returns string version of integer vector
 vector<int> str2vec(string); // returns an integer vector for a given solution string
+vector<double> average_ranks(const vector<double> &); // returns ranks of values, averaging the ranks of ties
 
 // Structure declarations
 struct Search;
 struct EventLog;
 struct MemoryLog;
 struct SolutionLog;
+struct FeasibilitySurrogate;
 
 /**
 Search object.
@@ -65,10 +69,17 @@ struct Search
 	EventLog * EveLog; // pointer to event log object
 	MemoryLog * MemLog; // pointer to memory log object
 	SolutionLog * SolLog; // pointer to solution log object
+	Network * CoarseNet = NULL; // pointer to coarse network object (NULL if coarse screening is not used)
+	Objective * CoarseObj = NULL; // pointer to coarse network objective object
+	Constraint * CoarseCon = NULL; // pointer to coarse network constraint object (NULL if coarse feasibility is unused)
 
 	// Public attributes (search parameters and technical)
 	bool started = false; // whether or not the solve() method has been called
 	bool keyboard_halt = false; // whether or not to stop due to a keyboard halt
+	bool searching = false; // whether a main loop neighborhood search is in progress
+	double tenure_start; // tabu tenure for new tabu moves at the start of the current neighborhood search
+	vector<double> add_tenure_start; // ADD tabu tenures at the start of the current neighborhood search
+	vector<double> drop_tenure_start; // DROP tabu tenures at the start of the current neighborhood search
 	bool pickup; // whether or not to continue a search from its saved data files (if false, log files are wiped clean)
 	bool exhaustive; // whether or not to end with an exhaustive search from the final solution
 	int sol_size; // size of solution vector
@@ -85,6 +96,17 @@ struct Search
 	int nonimp_in_max; // cutoff for inner nonimprovement counter
 	int nonimp_out_max; // cutoff for outer nonimprovement counter
 	int step; // step size for moves
+	double coarse_radius = 0.0; // walking time within which stops are aggregated for coarse screening (0 to skip)
+	int coarse_keep = 0; // new first-pass candidates promoted from coarse screening to full evaluation in each pass
+	bool coarse_constraint = false; // whether coarse screening also predicts constraint feasibility
+	int snapshot_recent = 0; // number of recently accepted solutions whose flows are kept for warm starts (0 to skip)
+	bool lockstep = false; // whether to evaluate the constraints of second-pass candidates together
+	int concurrency = CONCURRENCY_OFF; // whether to evaluate second-pass candidates concurrently (or automatic choice)
+	bool sensitivity = false; // whether to defer candidates that user cost sensitivities predict are infeasible
+	int surrogate_neighbors = 0; // logged neighbors used by the feasibility surrogate (0 to skip)
+	double surrogate_z = 2.0; // spreads by which a surrogate prediction must exceed the bound to be trusted
+	int speculation = 0; // extra second-pass candidates evaluated ahead of need alongside each window (0 for none)
+	CancelToken cancel; // cancellation token shared with the evaluators (holds the stop request and deadline)
 	vector<int> line_min; // lower vehicle bounds for all lines
 	vector<int> line_max; // upper vehicle bounds for all lines
 	vector<int> max_vehicles; // maximum number of each vehicle type
@@ -105,6 +127,9 @@ struct Search
 	list<pair<vector<int>, double>> attractive_solutions; // list of attractive sols, as solution vector/obj value pairs
 	vector<int> current_vehicles; // number of each vehicle type currently in use
 	int exhaustive_iteration; // iteration of exhaustive local search
+	list<vector<int>> recent_solutions; // most recently accepted solutions, newest first (for flow snapshots)
+	vector<double> add_uc_change; // predicted user cost change of each line's ADD move from the current solution
+	vector<double> drop_uc_change; // predicted user cost change of each line's DROP move from the current solution
 
 	// Public methods
 	Search(); // constructor initializes network, objective, constraint, and various logger objects
@@ -112,10 +137,24 @@ struct Search
 	void solve(); // main driver of the solution algorithm
 	neighbor_pair neighborhood_search(); // performs nbhd search to find the best and second best neighboring moves
 	vector<int> make_move(int, int); // returns the results of applying a move to the current solution
+	pair<bool, double> coarse_score(const vector<int> &); // predicted infeasibility and objective on the coarse network
+	vector<double> batch_objectives(const vector<vector<int>> &); // calculates and logs objectives of new solutions
+	int promote_candidates(screen_list &, candidate_queue &, unordered_set<int> &); // fully evaluates best screened
+	void coarse_report(); // compares coarse and full rankings of the logged solutions and writes them to a file
+	int lockstep_pass(candidate_queue &, candidate_queue &, list<pair<double, pair<int, int>>> &, int, neighbor_queue &,
+		int &); // second pass that evaluates new candidates together
+	bool predicted_infeasible(int, int); // whether the sensitivities or the surrogate predict that a move is infeasible
+	candidate_queue defer_predicted(candidate_queue &); // removes new candidates predicted to be infeasible
+	void restore_deferred(candidate_queue &, candidate_queue &); // returns unused deferred candidates to a queue
+	bool evaluate_swap(int, int, neighbor_queue &, int &, int &); // evaluates and logs a new SWAP candidate
+	bool unverified(const vector<int> &); // whether a logged status came from an estimate or loose tolerances
+	bool verify_candidate(const vector<int> &); // confirms a candidate's feasibility with a full tight assignment
+	void stop_check(); // safely quits in the middle of an iteration if a stop has been requested
 	void pop_attractive(bool); // deletes a random attractive solution and optionally sets it as the current solution
 	void vehicle_totals(); // calculates total vehicles of each type in use
 	void increase_tenure(); // increase the tabu tenure value
 	void cool_temperature(); // apply a cooling schedule to the simulated annealing temperature
+	void retain_snapshots(); // keeps the stored flows of the current, recent, best, and attractive solutions
 	void save_data(); // writes all current progress to the log files
 	pair<pair<int, int>, double> best_neighbor(); // finds best move from current solution via exhaustive nbhd search
 	void exhaustive_search(); // conducts an exhaustive local search from the current solution
@@ -221,28 +260,69 @@ incomplete, but may be filled in later if the constraint function value is neede
 revolve around looking up or filling in pieces of information about solutions.
 
 The most important attribute of this class is the solution log, which is an unordered map of solutions. The log is
-indexed by the string version of the corresponding solution vector. The entry in the log is a 5-part tuple consisting of
+indexed by the string version of the corresponding solution vector. The entry in the log is a 7-part tuple consisting of
 the following:
 	<0> the feasibility result
 	<1> a vector of constraint function elements
 	<2> the constraint evaluation time
 	<3> the objective value
 	<4> the objective evaluation time
+	<5> the source of the constraint function elements (full assignment, sampled estimate, full assignment stopped
+		early by its error bound, free-flow lower bound, or abandoned evaluation)
+	<6> the fidelity of the constraint function elements (tight or loose assignment tolerances)
 */
 struct SolutionLog
 {
 	// Public attributes
-	unordered_map<string, tuple<int, vector<double>, double, double, double>> sol_log; // dict of sols, by sol vec str
+	unordered_map<string, tuple<int, vector<double>, double, double, double, int, int>> sol_log; // dict of sols by str
+	FeasibilitySurrogate * Surrogate = NULL; // pointer to the surrogate trained on this log (NULL if not used)
 
 	// Public methods
 	SolutionLog(bool); // constructor reads the solution log file and initializes the solution memory structure
 	void load_solution(string); // reads a given solution log into the dictionary
 	void save_solution(); // writes the current solution log to the log file
-	void create_row(const vector<int> &, int, const vector<double> &, double, double, double); // updates sol log entry
+	void create_row(const vector<int> &, int, const vector<double> &, double, double, double, int,
+		int); // creates or overwrites a sol log entry
 	void create_partial_row(const vector<int> &, double, double); // creates sol log entry for sol given obj and time
 	bool solution_exists(const vector<int> &); // determines whether a given sol vector is present in the solution log
 	tuple<int, vector<double>, double> lookup_row(const vector<int> &); // returns feas, constraint elements, and obj
 	pair<int, double> lookup_row_quick(const vector<int> &); // returns feas and objof a given solution
-	void update_row(const vector<int> &, int, const vector<double> &, double); // modifies feas, cons, and time
+	void update_row(const vector<int> &, int, const vector<double> &, double, int, int); // modifies feas, cons, etc.
+	int lookup_fidelity(const vector<int> &); // returns the tolerance profile that produced a solution's feasibility
+	int lookup_source(const vector<int> &); // returns the source code of a solution's constraint function values
 	void ban_solution(const vector<int> &); // bans a solution so that it will never be searched again
 };
+
+/**
+Feasibility surrogate.
+
+Predicts the total user cost and feasibility of solutions that have not yet been evaluated, using the solutions in the
+solution log whose user costs came from full assignments. The prediction is a nearest-neighbor regression: the logged
+solutions nearest to the candidate (by the total absolute difference of their fleet sizes) are found, and their total
+user costs are averaged with weights inversely proportional to their distances. The spread of the prediction is the
+weighted standard deviation of the same user costs. Since a neighborhood search only considers solutions near the
+current solution, which are usually near many previously evaluated solutions, this captures the local shape of the user
+cost.
+
+The training set is updated incrementally whenever the solution log gains or changes a row, so no separate retraining
+step is needed. The calibration of the predictions is measured by leave-one-out prediction over the training set.
+*/
+struct FeasibilitySurrogate
+{
+	// Public attributes
+	vector<vector<int>> sols; // solution vector of each training row
+	vector<double> user_costs; // total user cost of each training row
+	vector<int> feasibility; // logged feasibility status of each training row
+	unordered_map<string, int> rows; // training row of each solution string
+	int neighbors; // number of nearest training rows used for each prediction (ties at the last distance included)
+	double z; // number of spreads by which a prediction must exceed the bound to be confidently infeasible
+	double bound; // user cost upper bound (infinite if the user cost constraint is disabled)
+	vector<double> weights; // user cost weights of the riding, walking, and waiting components
+
+	// Public methods
+	FeasibilitySurrogate(SolutionLog *, Constraint *, int, double); // constructor trains on the existing log rows
+	void train(const string &, int, const vector<double> &, int); // adds or updates the training row of a log entry
+	pair<double, double> predict(const vector<int> &, int = -1); // predicted user cost and spread, excluding a row
+	bool confidently_infeasible(const vector<int> &); // whether a solution is confidently predicted infeasible
+	void report(); // writes the leave-one-out calibration of the predictions to a file
+};
@@ -83,3 +83,26 @@ vector<int> str2vec(string sol)
 
 	return out;
 }
+
+/// Returns the ascending ranks (beginning at 1) of a vector of values, with tied values sharing their mean rank.
+vector<double> average_ranks(const vector<double> &values)
+{
+	vector<int> order(values.size());
+	for (int i = 0; i < order.size(); i++)
+		order[i] = i;
+	sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+
+	vector<double> ranks(values.size());
+	int first = 0; // position of first value in the current group of ties
+	while (first < order.size())
+	{
+		int last = first; // position of last value in the current group of ties
+		while ((last + 1 < order.size()) && (values[order[last + 1]] == values[order[first]]))
+			last++;
+		for (int i = first; i <= last; i++)
+			ranks[order[i]] = (first + last) / 2.0 + 1;
+		first = last + 1;
+	}
+
+	return ranks;
+}
@@ -45,6 +45,8 @@ void SolutionLog::load_solution(string in_file)
 			double row_con_time;
 			double row_obj;
 			double row_obj_time;
+			int row_con_source = CON_SOURCE_FULL;
+			int row_con_fidelity = FIDELITY_TIGHT;
 
 			// Go through each piece of the line
 			getline(stream, piece, '\t'); // Solution
@@ -63,13 +65,20 @@ void SolutionLog::load_solution(string in_file)
 			row_obj = stod(piece);
 			getline(stream, piece, '\t'); // Objective time
 			row_obj_time = stod(piece);
+			if (getline(stream, piece, '\t'))
+				// Constraint source (optional, since older logs do not include it)
+				row_con_source = stoi(piece);
+			if (getline(stream, piece, '\t'))
+				// Constraint tolerance profile (optional, since older logs do not include it)
+				row_con_fidelity = stoi(piece);
 
 			// Set banned solutions back to feasible
 			if (row_feas == FEAS_BAN)
 				row_feas = FEAS_TRUE;
 
 			// Create dictionary entry
-			sol_log[row_sol] = make_tuple(row_feas, row_uc, row_con_time, row_obj, row_obj_time);
+			sol_log[row_sol] = make_tuple(row_feas, row_uc, row_con_time, row_obj, row_obj_time, row_con_source,
+				row_con_fidelity);
 		}
 
 		log_file.close();
@@ -89,8 +98,8 @@ void SolutionLog::save_solution()
 	if (log_file.is_open())
 	{
 		// Write comment line
-		log_file << "Solution\tFeasible\tUC_Riding\tUC_Walking\tUC_Waiting\tCon_Time\tObjective\tObj_Time" << fixed <<
-			setprecision(15) << endl;
+		log_file << "Solution\tFeasible\tUC_Riding\tUC_Walking\tUC_Waiting\tCon_Time\tObjective\tObj_Time\t" <<
+			"Con_Source\tCon_Fidelity" << fixed << setprecision(15) << endl;
 
 		// Write rows by iterating through dictionary (order is arbitrary)
 		for (auto it = sol_log.begin(); it != sol_log.end(); it++)
@@ -99,7 +108,8 @@ void SolutionLog::save_solution()
 			for (int i = 0; i < UC_COMPONENTS; i++)
 				log_file << get<SOL_LOG_UC>(it->second)[i] << '\t';
 			log_file << get<SOL_LOG_CON_TIME>(it->second) << '\t' << get<SOL_LOG_OBJ>(it->second) << '\t' <<
-				get<SOL_LOG_OBJ_TIME>(it->second) << endl;
+				get<SOL_LOG_OBJ_TIME>(it->second) << '\t' << get<SOL_LOG_CON_SOURCE>(it->second) << '\t' <<
+				get<SOL_LOG_CON_FIDELITY>(it->second) << endl;
 		}
 
 		log_file.close();
@@ -113,21 +123,26 @@ void SolutionLog::save_solution()
 Creates or updates a solution log entry for a given solution.
 
 Requires a solution vector reference, feasibility status, constraint function vector reference, constraint calculation
-time, objective value, and objective calculation time, respectively.
+time, objective value, objective calculation time, constraint source code, and constraint tolerance profile code,
+respectively.
 
 If the solution vector was not already present in the log, this will add a new row. If it was already present, this will
-overwrite its previous information.
+overwrite its previous information. The feasibility surrogate (if any) is updated with the new information.
 */
 void SolutionLog::create_row(const vector<int> &sol, int feas, const vector<double> &ucc, double uc_time,
-	double obj, double obj_time)
+	double obj, double obj_time, int source, int fidelity)
 {
-	sol_log[vec2str(sol)] = make_tuple(feas, ucc, uc_time, obj, obj_time);
+	string key = vec2str(sol); // solution log key
+	sol_log[key] = make_tuple(feas, ucc, uc_time, obj, obj_time, source, fidelity);
+	if (Surrogate != NULL)
+		Surrogate->train(key, feas, ucc, source);
 }
 
 /// Creates a partial solution log entry for a given solution, objective value, and objective calculation time.
 void SolutionLog::create_partial_row(const vector<int> &sol, double obj, double obj_time)
 {
-	create_row(sol, FEAS_UNKNOWN, vector<double>(UC_COMPONENTS, FEAS_UNKNOWN), FEAS_UNKNOWN, obj, obj_time);
+	create_row(sol, FEAS_UNKNOWN, vector<double>(UC_COMPONENTS, FEAS_UNKNOWN), FEAS_UNKNOWN, obj, obj_time,
+		CON_SOURCE_FULL, FIDELITY_TIGHT);
 }
 
 /// Returns a boolean indicating whether a given solution vector is present in the solution log.
@@ -145,7 +160,7 @@ given solution vector.
 */
 tuple<int, vector<double>, double> SolutionLog::lookup_row(const vector<int> &sol)
 {
-	tuple<int, vector<double>, double, double, double> entry = sol_log[vec2str(sol)]; // raw log entry
+	tuple<int, vector<double>, double, double, double, int, int> entry = sol_log[vec2str(sol)]; // raw log entry
 
 	// Output tuple of specified elements
 	return make_tuple(get<SOL_LOG_FEAS>(entry), get<SOL_LOG_UC>(entry), get<SOL_LOG_OBJ>(entry));
@@ -154,7 +169,7 @@ tuple<int, vector<double>, double> SolutionLog::lookup_row(const vector<int> &so
 /// Returns a pair containing the feasibility status and objective value for a given solution vector.
 pair<int, double> SolutionLog::lookup_row_quick(const vector<int> &sol)
 {
-	tuple<int, vector<double>, double, double, double> entry = sol_log[vec2str(sol)]; // raw log entry
+	tuple<int, vector<double>, double, double, double, int, int> entry = sol_log[vec2str(sol)]; // raw log entry
 
 	// Output tuple of specified elements
 	return make_pair(get<SOL_LOG_FEAS>(entry), get<SOL_LOG_OBJ>(entry));
@@ -164,13 +179,14 @@ pair<int, double> SolutionLog::lookup_row_quick(const vector<int> &sol)
 Modifies the feasibility status, constraint function vector, and constraint evaluation time for a previously-logged
 solution.
 
-Requires a solution vector reference, feasibility status, constraint vector reference, and constraint time,
-respectively.
+Requires a solution vector reference, feasibility status, constraint vector reference, constraint time, constraint
+source code, and constraint tolerance profile code, respectively.
 
 This method is used to fill in constraint evaluation information for solutions whose constraint evaluation had
 previously been skipped during a neighborhood search.
 */
-void SolutionLog::update_row(const vector<int> &sol, int feas, const vector<double> &ucc, double uc_time)
+void SolutionLog::update_row(const vector<int> &sol, int feas, const vector<double> &ucc, double uc_time, int source,
+	int fidelity)
 {
 	string key = vec2str(sol); // solution log key
 
@@ -178,6 +194,22 @@ void SolutionLog::update_row(const vector<int> &sol, int feas, const vector<doub
 	get<SOL_LOG_FEAS>(sol_log[key]) = feas;
 	get<SOL_LOG_UC>(sol_log[key]) = ucc;
 	get<SOL_LOG_CON_TIME>(sol_log[key]) = uc_time;
+	get<SOL_LOG_CON_SOURCE>(sol_log[key]) = source;
+	get<SOL_LOG_CON_FIDELITY>(sol_log[key]) = fidelity;
+	if (Surrogate != NULL)
+		Surrogate->train(key, feas, ucc, source);
+}
+
+/// Returns the tolerance profile code of the assignment model evaluation that produced a given solution's feasibility.
+int SolutionLog::lookup_fidelity(const vector<int> &sol)
+{
+	return get<SOL_LOG_CON_FIDELITY>(sol_log[vec2str(sol)]);
+}
+
+/// Returns the source code of a given solution's constraint function values.
+int SolutionLog::lookup_source(const vector<int> &sol)
+{
+	return get<SOL_LOG_CON_SOURCE>(sol_log[vec2str(sol)]);
 }
 
 /**
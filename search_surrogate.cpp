@@ -0,0 +1,226 @@
+/// Feasibility surrogate class methods.
+
+#include "search.hpp"
+
+/**
+Feasibility surrogate constructor trains the surrogate on the rows already in the solution log.
+
+Requires pointers to the solution log and the main constraint object, followed by the number of neighbors used for each
+prediction and the number of spreads required for a confident prediction, respectively.
+
+The user cost weights and bound are copied from the constraint object, so that the total user costs and the feasibility
+decisions match those of the constraint evaluations.
+*/
+FeasibilitySurrogate::FeasibilitySurrogate(SolutionLog * SolLog, Constraint * Con, int k, double z_value)
+{
+	neighbors = k;
+	z = z_value;
+	weights = { Con->riding_weight, Con->walking_weight, Con->waiting_weight };
+	if (Con->uc_percent_increase < 0)
+		bound = INFINITY;
+	else
+		bound = (1 + Con->uc_percent_increase)*Con->initial_user_cost;
+
+	for (auto it = SolLog->sol_log.begin(); it != SolLog->sol_log.end(); it++)
+		train(it->first, get<SOL_LOG_FEAS>(it->second), get<SOL_LOG_UC>(it->second),
+			get<SOL_LOG_CON_SOURCE>(it->second));
+}
+
+/**
+Adds, updates, or removes the training row of a solution log entry.
+
+Requires the solution string, feasibility status, constraint function vector, and constraint source code of the entry,
+respectively.
+
+Only entries of known feasibility whose user cost components came from a full assignment (including one stopped early
+by its error bound) are used for training, since the sampled estimates and lower bounds of the other sources would bias
+the predictions. Entries with a nonpositive total user cost, such as placeholder rows in an initial solution log, are
+also left out. An entry that no longer qualifies has its row removed.
+*/
+void FeasibilitySurrogate::train(const string &key, int feas, const vector<double> &ucc, int source)
+{
+	double total = 0.0; // total user cost
+	for (int i = 0; i < UC_COMPONENTS; i++)
+		total += weights[i] * ucc[i];
+	bool usable = ((feas != FEAS_UNKNOWN) && ((source == CON_SOURCE_FULL) || (source == CON_SOURCE_BOUND)) &&
+		(total > 0)); // whether the entry can be trained on
+	auto found = rows.find(key); // existing training row of the entry (if any)
+
+	if (usable == false)
+	{
+		// Remove an existing row by moving the last row into its place
+		if (found == rows.end())
+			return;
+		int r = found->second;
+		int last = sols.size() - 1;
+		rows.erase(found);
+		if (r != last)
+		{
+			sols[r].swap(sols[last]);
+			user_costs[r] = user_costs[last];
+			feasibility[r] = feasibility[last];
+			rows[vec2str(sols[r])] = r;
+		}
+		sols.pop_back();
+		user_costs.pop_back();
+		feasibility.pop_back();
+		return;
+	}
+
+	// Add or overwrite the row
+	if (found == rows.end())
+	{
+		rows[key] = sols.size();
+		sols.push_back(str2vec(key));
+		user_costs.push_back(total);
+		feasibility.push_back(feas);
+	}
+	else
+	{
+		user_costs[found->second] = total;
+		feasibility[found->second] = feas;
+	}
+}
+
+/**
+Predicts the total user cost of a solution.
+
+Requires a solution vector and, optionally, a training row to leave out of the prediction (for measuring calibration).
+
+Returns a pair containing the predicted total user cost and its spread. If there are fewer training rows than the
+number of neighbors then no prediction is made, and the spread is infinite. A solution that is itself a training row is
+predicted exactly.
+*/
+pair<double, double> FeasibilitySurrogate::predict(const vector<int> &sol, int exclude)
+{
+	// Find the distance to every training row
+	vector<pair<int, int>> distances; // distance/row pairs
+	distances.reserve(sols.size());
+	for (int r = 0; r < sols.size(); r++)
+	{
+		if (r == exclude)
+			continue;
+		int d = 0; // total absolute fleet size difference
+		for (int i = 0; i < sol.size(); i++)
+			d += abs(sol[i] - sols[r][i]);
+		if (d == 0)
+			return make_pair(user_costs[r], 0.0);
+		distances.push_back(make_pair(d, r));
+	}
+	if ((neighbors < 1) || (distances.size() < neighbors))
+		return make_pair(0.0, INFINITY);
+
+	// Average the user costs of the nearest rows (including all ties with the farthest one)
+	nth_element(distances.begin(), distances.begin() + (neighbors - 1), distances.end());
+	int farthest = distances[neighbors - 1].first; // distance of the farthest neighbor
+	double total_weight = 0.0; // sum of neighbor weights
+	double mean = 0.0; // weighted mean user cost
+	for (int j = 0; j < distances.size(); j++)
+	{
+		if (distances[j].first > farthest)
+			continue;
+		double w = 1.0 / distances[j].first;
+		total_weight += w;
+		mean += w * user_costs[distances[j].second];
+	}
+	mean /= total_weight;
+	double variance = 0.0; // weighted variance of the neighbor user costs
+	for (int j = 0; j < distances.size(); j++)
+	{
+		if (distances[j].first > farthest)
+			continue;
+		double deviation = user_costs[distances[j].second] - mean;
+		variance += deviation * deviation / distances[j].first;
+	}
+	variance /= total_weight;
+
+	return make_pair(mean, sqrt(variance));
+}
+
+/**
+Decides whether a solution is confidently predicted to be infeasible.
+
+Requires a solution vector.
+
+Returns true if the predicted total user cost exceeds the bound by more than the chosen number of spreads, and false
+otherwise (including when no prediction can be made).
+*/
+bool FeasibilitySurrogate::confidently_infeasible(const vector<int> &sol)
+{
+	if (isfinite(bound) == false)
+		return false;
+	pair<double, double> prediction = predict(sol);
+	if (isfinite(prediction.second) == false)
+		return false;
+	return (prediction.first - z*prediction.second > bound);
+}
+
+/**
+Measures the calibration of the surrogate and writes it to the surrogate report file.
+
+Each training row is predicted from all of the others, and the predictions are compared to the row's logged user cost
+and feasibility. The report includes the mean absolute error, the fraction of user costs that fall within the chosen
+number of spreads of their predictions, and how often a confident infeasibility prediction was correct (precision) and
+how many of the infeasible rows were confidently predicted (recall), followed by every row's prediction.
+*/
+void FeasibilitySurrogate::report()
+{
+	// Predict every row from the others
+	int n = sols.size(); // number of training rows
+	vector<pair<double, double>> predictions(n); // leave-one-out prediction of each row
+	parallel_for(0, n, [&](int r)
+	{
+		predictions[r] = predict(sols[r], r);
+	});
+
+	// Compare the predictions to the logged values
+	int predicted = 0; // rows with a prediction
+	double abs_error = 0.0; // total absolute prediction error
+	int covered = 0; // rows whose user cost is within the chosen number of spreads of its prediction
+	int confident = 0; // rows confidently predicted to be infeasible
+	int confident_correct = 0; // confidently infeasible rows that are infeasible
+	int infeasible = 0; // infeasible rows with a prediction
+	vector<int> flagged(n, 0); // whether each row is confidently predicted to be infeasible
+	for (int r = 0; r < n; r++)
+	{
+		if (isfinite(predictions[r].second) == false)
+			continue;
+		predicted++;
+		abs_error += abs(predictions[r].first - user_costs[r]);
+		if (abs(predictions[r].first - user_costs[r]) <= z*predictions[r].second)
+			covered++;
+		if (feasibility[r] == FEAS_FALSE)
+			infeasible++;
+		if (predictions[r].first - z*predictions[r].second > bound)
+		{
+			flagged[r] = 1;
+			confident++;
+			if (feasibility[r] == FEAS_FALSE)
+				confident_correct++;
+		}
+	}
+
+	// Write report
+	ofstream report_file(FILE_BASE + SURROGATE_REPORT_FILE);
+	if (report_file.is_open())
+	{
+		report_file << fixed << setprecision(15);
+		report_file << "Label\tValue" << endl;
+		report_file << "Solutions\t" << predicted << endl;
+		report_file << "Mean_Abs_Error\t" << ((predicted > 0) ? abs_error / predicted : -1.0) << endl;
+		report_file << "Coverage\t" << ((predicted > 0) ? (1.0*covered) / predicted : -1.0) << endl;
+		report_file << "Confident_Infeasible\t" << confident << endl;
+		report_file << "Precision\t" << ((confident > 0) ? (1.0*confident_correct) / confident : -1.0) << endl;
+		report_file << "Recall\t" << ((infeasible > 0) ? (1.0*confident_correct) / infeasible : -1.0) << endl;
+		report_file << "Solution\tUser_Cost\tPredicted\tSpread\tFeasible\tConfident_Infeasible" << endl;
+		for (int r = 0; r < n; r++)
+			if (isfinite(predictions[r].second) == true)
+				report_file << vec2str(sols[r]) << '\t' << user_costs[r] << '\t' << predictions[r].first << '\t' <<
+					predictions[r].second << '\t' << feasibility[r] << '\t' << flagged[r] << endl;
+		report_file.close();
+		cout << "Surrogate mean absolute user cost error over " << predicted << " logged solutions: " <<
+			((predicted > 0) ? abs_error / predicted : -1.0) << endl;
+	}
+	else
+		cout << "Failed to write surrogate report." << endl;
+}